@@ -0,0 +1,591 @@
+/**
+ * 1D Row Distribution
+ * Every process owns about N/P consecutive rows of A and C and needs all of B:
+ *   local_C (rows x N) = local_A (rows x N) * B (N x N)
+ * When P does not divide N the first N % P processes get one extra row.
+ *
+ * Rank 0 owns the first rows. When it holds the full A or C (input from
+ * rank 0, output gathered on rank 0) it works on its rows in place in
+ * ctx->A / ctx->C with MPI_IN_PLACE, instead of keeping a second copy.
+ *
+ * Every collective counts whole rows of N elements (row_type for A and B,
+ * c_row_type for C) rather than elements, so the int counts and offsets
+ * MPI takes stay below N even when N * N or a process's rows * N does not
+ * fit in an int.
+ *
+ * With distributed input (see rows_load) every process generates its own
+ * rows of A and a share of the rows of B, and the broadcast of B becomes an
+ * allgather of those shares.
+ *
+ * Three ways of getting B to the processes are implemented:
+ *   1d        - MPI_Bcast B to every process, so each one holds its own copy.
+ *   shared    - one copy of B per node in an MPI-3 shared memory window. Only
+ *               one process per node (the node leader) takes part in the
+ *               broadcast, the others read B straight from the leader's memory.
+ *   pipelined - like 1d, but B is broadcast in panels of rows with
+ *               MPI_Ibcast and the multiplication starts on the first panel
+ *               while the following ones are still on their way.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <mpi.h>
+#include "algorithms.h"
+
+// Rows of B per broadcast panel in the pipelined algorithm
+#ifndef PIPELINE_PANEL
+#define PIPELINE_PANEL 256
+#endif
+
+// Each panel product is split into this many kernel calls, with an MPI_Test
+// in between so the broadcast of the next panel keeps making progress
+#ifndef PIPELINE_SLICES
+#define PIPELINE_SLICES 4
+#endif
+
+#define MIN(a, b) ((a) < (b) ? (a) : (b))
+
+typedef struct {
+    int rows;                // rows of A and C owned by this process
+    int first_row;           // global index of the first of them
+    int *counts, *displs;    // rows of A/C owned by, and first row of, every process
+    MPI_Datatype row_type;   // one row of A or B, N elements, the unit of every collective
+    MPI_Datatype c_row_type; // one row of C, N elements
+    void *local_A, *local_C;
+    int a_in_place;          // rank 0 uses the first rows of ctx->A instead of local_A
+    int c_in_place;          // rank 0 uses the first rows of ctx->C instead of local_C
+
+    // shared mode only
+    MPI_Comm node_comm;      // processes that can share memory with this one
+    MPI_Comm leader_comm;    // rank 0 of every node_comm, MPI_COMM_NULL elsewhere
+    MPI_Win win;             // window holding B, MPI_WIN_NULL in 1d mode
+    int *node_counts;        // rows of B loaded by, and first row of, every node
+    int *node_displs;
+    int b_first_row, b_rows; // rows of B this process loads with distributed input
+} rows_state;
+
+/**
+ * split_rows
+ * ----------
+ * Splits n rows as evenly as possible into `parts` consecutive ranges, the
+ * first n % parts ranges get one extra row. Sets the first row and the
+ * number of rows of range `index`.
+ */
+void split_rows(int n, int parts, int index, int *first, int *count) {
+    int base = n / parts, extra = n % parts;
+    *count = base + (index < extra ? 1 : 0);
+    *first = index * base + (index < extra ? index : extra);
+}
+
+/**
+ * rows_alloc
+ * ----------
+ * Common part of the setup hooks: works out how many rows every process
+ * gets and allocates the local chunks of A and C.
+ */
+static int rows_alloc(run_ctx *ctx) {
+    int N = ctx->N, size = ctx->size;
+
+    rows_state *st = calloc(1, sizeof(rows_state));
+    if (!st) {
+        fprintf(stderr, "Memory allocation failed\n");
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+    st->node_comm = MPI_COMM_NULL;
+    st->leader_comm = MPI_COMM_NULL;
+    st->win = MPI_WIN_NULL;
+
+    // how many rows of the matrix each process handles, the counts and
+    // offsets for MPI_Scatterv/MPI_Gatherv are in rows
+    st->counts = malloc(size * sizeof(int));
+    st->displs = malloc(size * sizeof(int));
+    if (!st->counts || !st->displs) {
+        fprintf(stderr, "Memory allocation failed\n");
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+    for (int r = 0; r < size; r++) {
+        int first, rows;
+        split_rows(N, size, r, &first, &rows);
+        st->counts[r] = rows;
+        st->displs[r] = first;
+    }
+    MPI_Type_contiguous(N, ctx->in_type, &st->row_type);
+    MPI_Type_commit(&st->row_type);
+    MPI_Type_contiguous(N, ctx->out_type, &st->c_row_type);
+    MPI_Type_commit(&st->c_row_type);
+    split_rows(N, size, ctx->rank, &st->first_row, &st->rows);
+    st->b_first_row = st->first_row;
+    st->b_rows = st->rows;
+
+    st->a_in_place = (ctx->rank == 0 && !ctx->distributed_input);
+    st->c_in_place = (ctx->rank == 0 && !ctx->distributed_output);
+    if (!st->a_in_place) st->local_A = malloc((size_t)st->rows * N * ctx->in_size);
+    if (!st->c_in_place) st->local_C = malloc((size_t)st->rows * N * ctx->out_size);
+    // with more processes than rows some processes own nothing, malloc(0) may return NULL
+    if (st->rows > 0 && ((!st->a_in_place && !st->local_A) || (!st->c_in_place && !st->local_C))) {
+        fprintf(stderr, "Memory allocation failed\n");
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+
+    ctx->priv = st;
+    return 0;
+}
+
+/**
+ * rows_A / rows_C
+ * ---------------
+ * This process's rows of A and C: local_A / local_C, or on rank 0 the
+ * first rows of the full matrix when it works in place.
+ */
+static void *rows_A(const run_ctx *ctx, const rows_state *st) {
+    return st->a_in_place ? ctx->A : st->local_A;
+}
+
+static void *rows_C(const run_ctx *ctx, const rows_state *st) {
+    return st->c_in_place ? ctx->C : st->local_C;
+}
+
+/**
+ * rows_setup
+ * ----------
+ * Setup for the 1d algorithm: every process gets its own full copy of B.
+ */
+int rows_setup(run_ctx *ctx) {
+    if (rows_alloc(ctx) != 0) return 1;
+
+    ctx->B = malloc((size_t)ctx->N * ctx->N * ctx->in_size);
+    if (!ctx->B) {
+        fprintf(stderr, "Memory allocation failed\n");
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+    return 0;
+}
+
+/**
+ * rows_shared_setup
+ * -----------------
+ * Setup for the shared algorithm: B lives in a shared memory window that
+ * is allocated once per node.
+ *
+ * Notes:
+ *   - MPI_Comm_split_type(MPI_COMM_TYPE_SHARED) groups the processes that
+ *     can share memory, i.e. the ones on the same node.
+ *   - The leader (rank 0 of the node) allocates all N*N elements of the
+ *     window, every other process allocates 0 bytes and looks up the
+ *     leader's segment with MPI_Win_shared_query.
+ *   - The leaders form their own communicator for the inter-node broadcast.
+ *     World rank 0 is always leader 0 because the split keeps rank order.
+ *   - With distributed input the rows of B are split between the nodes, and
+ *     each node's share again between its processes. That way every node's
+ *     share is contiguous in the window no matter how ranks map to nodes.
+ */
+int rows_shared_setup(run_ctx *ctx) {
+    if (rows_alloc(ctx) != 0) return 1;
+    rows_state *st = ctx->priv;
+
+    MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, ctx->rank,
+                        MPI_INFO_NULL, &st->node_comm);
+    int node_rank;
+    MPI_Comm_rank(st->node_comm, &node_rank);
+    MPI_Comm_split(MPI_COMM_WORLD, node_rank == 0 ? 0 : MPI_UNDEFINED, ctx->rank,
+                   &st->leader_comm);
+
+    MPI_Aint bytes = node_rank == 0 ? (MPI_Aint)ctx->N * ctx->N * ctx->in_size : 0;
+    void *base;
+    MPI_Win_allocate_shared(bytes, (int)ctx->in_size, MPI_INFO_NULL, st->node_comm,
+                            &base, &st->win);
+
+    MPI_Aint segment_size;
+    int disp_unit;
+    MPI_Win_shared_query(st->win, 0, &segment_size, &disp_unit, &ctx->B);
+
+    // which node this is and how many there are, known to the leaders only
+    int node_index = 0, num_nodes = 0, node_size;
+    if (st->leader_comm != MPI_COMM_NULL) {
+        MPI_Comm_rank(st->leader_comm, &node_index);
+        MPI_Comm_size(st->leader_comm, &num_nodes);
+    }
+    MPI_Bcast(&node_index, 1, MPI_INT, 0, st->node_comm);
+    MPI_Bcast(&num_nodes, 1, MPI_INT, 0, st->node_comm);
+    MPI_Comm_size(st->node_comm, &node_size);
+
+    st->node_counts = malloc(num_nodes * sizeof(int));
+    st->node_displs = malloc(num_nodes * sizeof(int));
+    if (!st->node_counts || !st->node_displs) {
+        fprintf(stderr, "Memory allocation failed\n");
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+    for (int n = 0; n < num_nodes; n++) {
+        int first, rows;
+        split_rows(ctx->N, num_nodes, n, &first, &rows);
+        st->node_counts[n] = rows;
+        st->node_displs[n] = first;
+    }
+
+    int node_first = st->node_displs[node_index];
+    int node_rows = st->node_counts[node_index];
+    split_rows(node_rows, node_size, node_rank, &st->b_first_row, &st->b_rows);
+    st->b_first_row += node_first;
+
+    // keep a passive target epoch open for the whole run, so MPI_Win_sync
+    // can be used to make the leader's writes visible to the other processes
+    MPI_Win_lock_all(MPI_MODE_NOCHECK, st->win);
+    return 0;
+}
+
+/**
+ * rows_load
+ * ---------
+ * Distributed input for all three algorithms: every process fills its own
+ * rows of A and its share of the rows of B, in place in its copy of B (or
+ * in the node's window for the shared algorithm).
+ */
+void rows_load(run_ctx *ctx) {
+    rows_state *st = ctx->priv;
+    int N = ctx->N;
+
+    ctx->fill(ctx, MATRIX_A, st->first_row, 0, st->rows, N, st->local_A, N);
+    ctx->fill(ctx, MATRIX_B, st->b_first_row, 0, st->b_rows, N,
+              ELEM(ctx->B, (size_t)st->b_first_row * N, ctx->in_size), N);
+}
+
+/**
+ * rows_multiply
+ * -------------
+ * Second half of both algorithms, once every process can read B: scatter
+ * A, multiply locally and gather C on rank 0.
+ */
+static void rows_multiply(run_ctx *ctx) {
+    rows_state *st = ctx->priv;
+    int N = ctx->N;
+    size_t count = (size_t)st->rows * N;
+    void *local_A = rows_A(ctx, st), *local_C = rows_C(ctx, st);
+    double t = MPI_Wtime();
+
+    // int MPI_Scatterv(
+    //     const void *sendbuf,    starting address of send buffer (root only)
+    //     const int sendcounts[], number of elements (here rows) sent to each process
+    //     const int displs[],     offset of each process's elements in sendbuf
+    //     MPI_Datatype sendtype,  type of each send element
+    //     void *recvbuf,          starting address of receive buffer
+    //     int recvcount,          number of elements received by this process
+    //     MPI_Datatype recvtype,  type of each receive element
+    //     int root,               rank of sending process
+    //     MPI_Comm comm,          communicator
+    // );
+
+    // Spreads out A across all processes, unlike MPI_Scatter every process
+    // may receive a different number of rows. Not needed when every process
+    // loaded its own rows. Rank 0 keeps its rows where they are (MPI_IN_PLACE).
+    if (!ctx->distributed_input) {
+        MPI_Scatterv(ctx->A, st->counts, st->displs, st->row_type,
+                     st->a_in_place ? MPI_IN_PLACE : local_A, st->rows, st->row_type,
+                     0, MPI_COMM_WORLD);
+        if (ctx->rank != 0) ctx->bytes[PHASE_SCATTER] += (double)count * ctx->in_size;
+    }
+    phase_lap(ctx->times, PHASE_SCATTER, &t);
+
+    // the kernels accumulate into local_C, so it has to start out as 0's
+    memset(local_C, 0, count * ctx->out_size);
+
+    // Local matrix multiplication: local_C (rows x N) += local_A * B
+    ctx->kernel->fn[ctx->precision](st->rows, N, N, local_A, N, ctx->B, N, local_C, N);
+    phase_lap(ctx->times, PHASE_COMPUTE, &t);
+
+    // int MPI_Gatherv(
+    //     const void *sendbuf,    starting address of local data to send
+    //     int sendcount,          number of elements sent by this process
+    //     MPI_Datatype sendtype,  type of each element sent
+    //     void *recvbuf,          starting address of buffer to receive gathered data (root only)
+    //     const int recvcounts[], number of elements received from each process
+    //     const int displs[],     offset in recvbuf where each process's elements go
+    //     MPI_Datatype recvtype,  type of each received element
+    //     int root,               rank of receiving process
+    //     MPI_Comm comm,          communicator
+    // );
+
+    // Gather the local C buffers to compile the entire C result matrix in one process
+    // (skipped when C stays distributed), rank 0's rows are already in place
+    if (!ctx->distributed_output) {
+        MPI_Gatherv(st->c_in_place ? MPI_IN_PLACE : local_C, st->rows, st->c_row_type,
+                    ctx->C, st->counts, st->displs, st->c_row_type, 0, MPI_COMM_WORLD);
+        if (ctx->rank == 0) ctx->bytes[PHASE_GATHER] += ((double)N * N - count) * ctx->out_size;
+    }
+    phase_lap(ctx->times, PHASE_GATHER, &t);
+}
+
+/**
+ * rows_run
+ * --------
+ * Timed part of the 1d algorithm.
+ */
+void rows_run(run_ctx *ctx) {
+    rows_state *st = ctx->priv;
+    int N = ctx->N;
+    double t = MPI_Wtime();
+
+    if (ctx->distributed_input) {
+        // every process already has its own rows of B, collect everyone else's
+        MPI_Allgatherv(MPI_IN_PLACE, 0, MPI_DATATYPE_NULL,
+                       ctx->B, st->counts, st->displs, st->row_type, MPI_COMM_WORLD);
+        ctx->bytes[PHASE_BROADCAST] += ((double)N - st->counts[ctx->rank]) * N * ctx->in_size;
+        phase_lap(ctx->times, PHASE_BROADCAST, &t);
+        rows_multiply(ctx);
+        return;
+    }
+
+    // int MPI_Bcast(
+    //     void *buffer,           starting address of buffer to broadcast
+    //     int count,              number of elements in buffer
+    //     MPI_Datatype datatype,  type of each element
+    //     int root,               rank of broadcasting process
+    //     MPI_Comm comm,          communicator
+    // );
+
+    // this gives each process the entire B matrix, all N rows of it
+    MPI_Bcast(ctx->B, N, st->row_type, 0, MPI_COMM_WORLD);
+    if (ctx->rank != 0) ctx->bytes[PHASE_BROADCAST] += (double)N * N * ctx->in_size;
+    phase_lap(ctx->times, PHASE_BROADCAST, &t);
+
+    rows_multiply(ctx);
+}
+
+/**
+ * rows_shared_run
+ * ---------------
+ * Timed part of the shared algorithm.
+ *
+ * Notes:
+ *   Only the node leaders broadcast B, so the traffic is between nodes
+ *   only. The sync/barrier/sync sequence is the usual way to make stores
+ *   into a shared window visible: the leader's writes are flushed before the
+ *   barrier and the other processes refresh their view after it.
+ *   With distributed input the node's share of B has to be complete before
+ *   the leader sends it, so there is one more sync before the allgather.
+ */
+void rows_shared_run(run_ctx *ctx) {
+    rows_state *st = ctx->priv;
+    int N = ctx->N;
+    double t = MPI_Wtime();
+
+    if (ctx->distributed_input) {
+        MPI_Win_sync(st->win);
+        MPI_Barrier(st->node_comm);
+        MPI_Win_sync(st->win);
+    }
+
+    if (st->leader_comm != MPI_COMM_NULL) {
+        int node_index;
+        MPI_Comm_rank(st->leader_comm, &node_index);
+        if (ctx->distributed_input) {
+            MPI_Allgatherv(MPI_IN_PLACE, 0, MPI_DATATYPE_NULL, ctx->B, st->node_counts,
+                           st->node_displs, st->row_type, st->leader_comm);
+            ctx->bytes[PHASE_BROADCAST] += ((double)N - st->node_counts[node_index]) * N * ctx->in_size;
+        } else {
+            MPI_Bcast(ctx->B, N, st->row_type, 0, st->leader_comm);
+            if (node_index != 0) ctx->bytes[PHASE_BROADCAST] += (double)N * N * ctx->in_size;
+        }
+    }
+    MPI_Win_sync(st->win);
+    MPI_Barrier(st->node_comm);
+    MPI_Win_sync(st->win);
+    phase_lap(ctx->times, PHASE_BROADCAST, &t);
+
+    rows_multiply(ctx);
+}
+
+/**
+ * pipeline_panel
+ * --------------
+ * One panel of B broadcast by the pipelined algorithm.
+ */
+typedef struct {
+    int first_row, rows;     // rows of B in the panel
+    int root;                // process that broadcasts it
+} pipeline_panel;
+
+/**
+ * make_panels
+ * -----------
+ * Cuts B into the panels broadcast by the pipelined algorithm.
+ *
+ * Returns:
+ *   Heap-allocated array of panels in row order, *count is set to its size.
+ *
+ * Notes:
+ *   With the input on rank 0 all panels come from rank 0. With distributed
+ *   input every process's share of B is cut into panels that it broadcasts
+ *   itself, so no process ever needs rows of B it did not load or receive.
+ */
+static pipeline_panel *make_panels(const run_ctx *ctx, const rows_state *st, int *count) {
+    int N = ctx->N;
+    int owners = ctx->distributed_input ? ctx->size : 1;
+    pipeline_panel *panels = malloc(((size_t)N / PIPELINE_PANEL + owners + 1) * sizeof(pipeline_panel));
+    if (!panels) {
+        fprintf(stderr, "Memory allocation failed\n");
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+
+    int n = 0;
+    for (int r = 0; r < owners; r++) {
+        int first = ctx->distributed_input ? st->displs[r] : 0;
+        int rows = ctx->distributed_input ? st->counts[r] : N;
+        for (int k = first; k < first + rows; k += PIPELINE_PANEL) {
+            panels[n].first_row = k;
+            panels[n].rows = MIN(PIPELINE_PANEL, first + rows - k);
+            panels[n].root = r;
+            n++;
+        }
+    }
+    *count = n;
+    return panels;
+}
+
+/**
+ * rows_pipelined_run
+ * ------------------
+ * Timed part of the pipelined algorithm.
+ *
+ * Notes:
+ *   - B is cut into panels of up to PIPELINE_PANEL rows, which are
+ *     contiguous in row-major order, so each one is broadcast with a single
+ *     MPI_Ibcast straight into its place in B.
+ *   - While panel p is multiplied (local_C += local_A[:, panel p] * panel p)
+ *     the broadcast of panel p + 1 is in flight, so apart from the first
+ *     panel the broadcast hides behind the computation. Only two panels are
+ *     outstanding at a time, the current one and the next one.
+ *   - Many MPI libraries only move data inside MPI calls, so the panel
+ *     product is done in PIPELINE_SLICES row slices with an MPI_Test of the
+ *     next panel's request after each one.
+ *   - The broadcast phase only counts the time spent in MPI calls for the
+ *     panels, i.e. the part of the broadcasts that was not hidden.
+ */
+void rows_pipelined_run(run_ctx *ctx) {
+    rows_state *st = ctx->priv;
+    int N = ctx->N;
+    size_t count = (size_t)st->rows * N;
+    void *local_A = rows_A(ctx, st), *local_C = rows_C(ctx, st);
+    MPI_Request scatter_req = MPI_REQUEST_NULL, req[2];
+    double t = MPI_Wtime();
+
+    int num_panels;
+    pipeline_panel *panels = make_panels(ctx, st, &num_panels);
+
+    // the scatter of A and the first panel of B travel at the same time
+    if (!ctx->distributed_input) {
+        MPI_Iscatterv(ctx->A, st->counts, st->displs, st->row_type,
+                      st->a_in_place ? MPI_IN_PLACE : local_A, st->rows, st->row_type,
+                      0, MPI_COMM_WORLD, &scatter_req);
+        if (ctx->rank != 0) ctx->bytes[PHASE_SCATTER] += (double)count * ctx->in_size;
+    }
+    MPI_Ibcast(ELEM(ctx->B, (size_t)panels[0].first_row * N, ctx->in_size), panels[0].rows, st->row_type,
+               panels[0].root, MPI_COMM_WORLD, &req[0]);
+
+    memset(local_C, 0, count * ctx->out_size);
+    MPI_Wait(&scatter_req, MPI_STATUS_IGNORE);
+    phase_lap(ctx->times, PHASE_SCATTER, &t);
+
+    int slice = (st->rows + PIPELINE_SLICES - 1) / PIPELINE_SLICES;
+
+    for (int p = 0; p < num_panels; p++) {
+        // start the next panel before waiting for this one (double buffering)
+        MPI_Request *next = &req[(p + 1) % 2];
+        *next = MPI_REQUEST_NULL;
+        if (p + 1 < num_panels) {
+            const pipeline_panel *np = &panels[p + 1];
+            MPI_Ibcast(ELEM(ctx->B, (size_t)np->first_row * N, ctx->in_size), np->rows, st->row_type,
+                       np->root, MPI_COMM_WORLD, next);
+        }
+        MPI_Wait(&req[p % 2], MPI_STATUS_IGNORE);
+        if (panels[p].root != ctx->rank) ctx->bytes[PHASE_BROADCAST] += (double)panels[p].rows * N * ctx->in_size;
+        phase_lap(ctx->times, PHASE_BROADCAST, &t);
+
+        int k0 = panels[p].first_row, kb = panels[p].rows;
+        const void *b_panel = ELEM(ctx->B, (size_t)k0 * N, ctx->in_size);
+        for (int i0 = 0; i0 < st->rows; i0 += slice) {
+            int flag;
+            ctx->kernel->fn[ctx->precision](MIN(slice, st->rows - i0), N, kb,
+                                            ELEM(local_A, (size_t)i0 * N + k0, ctx->in_size), N, b_panel, N,
+                                            ELEM(local_C, (size_t)i0 * N, ctx->out_size), N);
+            phase_lap(ctx->times, PHASE_COMPUTE, &t);
+            MPI_Test(next, &flag, MPI_STATUS_IGNORE);
+            phase_lap(ctx->times, PHASE_BROADCAST, &t);
+        }
+    }
+    free(panels);
+
+    if (!ctx->distributed_output) {
+        MPI_Gatherv(st->c_in_place ? MPI_IN_PLACE : local_C, st->rows, st->c_row_type,
+                    ctx->C, st->counts, st->displs, st->c_row_type, 0, MPI_COMM_WORLD);
+        if (ctx->rank == 0) ctx->bytes[PHASE_GATHER] += ((double)N * N - count) * ctx->out_size;
+    }
+    phase_lap(ctx->times, PHASE_GATHER, &t);
+}
+
+/**
+ * rows_store
+ * ----------
+ * Distributed output for all three algorithms: every process writes its
+ * rows of C, which are consecutive in the file.
+ */
+void rows_store(run_ctx *ctx, MPI_File fh) {
+    rows_state *st = ctx->priv;
+    matio_write_rows(fh, ctx->N, ctx->out_type, st->first_row, st->rows, rows_C(ctx, st));
+}
+
+/**
+ * rows_tile
+ * ---------
+ * Tiles for --verify: this process's rows of A and C, and of B the share
+ * it loads with distributed input. Every process holds all of B after run,
+ * the shares just make sure each row is reported once.
+ */
+void rows_tile(const run_ctx *ctx, int matrix, matrix_tile *t) {
+    const rows_state *st = ctx->priv;
+    int N = ctx->N;
+
+    t->c0 = 0;
+    t->cols = N;
+    t->ld = N;
+    t->size = (matrix == MATRIX_C) ? ctx->out_size : ctx->in_size;
+    if (matrix == MATRIX_B) {
+        t->r0 = st->b_first_row;
+        t->rows = st->b_rows;
+        t->data = ELEM(ctx->B, (size_t)st->b_first_row * N, ctx->in_size);
+    } else {
+        t->r0 = st->first_row;
+        t->rows = st->rows;
+        t->data = (matrix == MATRIX_A) ? rows_A(ctx, st) : rows_C(ctx, st);
+    }
+}
+
+/**
+ * rows_cleanup
+ * ------------
+ * Frees the local chunks and B, for all three algorithms.
+ */
+void rows_cleanup(run_ctx *ctx) {
+    rows_state *st = ctx->priv;
+
+    if (st->win != MPI_WIN_NULL) {
+        MPI_Win_unlock_all(st->win);
+        MPI_Win_free(&st->win);
+        MPI_Comm_free(&st->node_comm);
+        if (st->leader_comm != MPI_COMM_NULL) MPI_Comm_free(&st->leader_comm);
+    } else {
+        free(ctx->B);
+    }
+    ctx->B = NULL;
+
+    MPI_Type_free(&st->row_type);
+    MPI_Type_free(&st->c_row_type);
+    free(st->counts);
+    free(st->displs);
+    free(st->node_counts);
+    free(st->node_displs);
+    free(st->local_A);
+    free(st->local_C);
+    free(st);
+    ctx->priv = NULL;
+}
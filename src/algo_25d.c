@@ -0,0 +1,253 @@
+/**
+ * 2.5D Matrix Multiplication
+ * Communication-avoiding variant of SUMMA that spends extra memory to
+ * send fewer words. The P processes are arranged as c layers of q x q
+ * grids (P = c * q^2), and every layer holds a full copy of the block
+ * layout of A and B.
+ *
+ *   1. Rank 0 scatters the blocks of A and B to layer 0 (or, with
+ *      distributed input, layer 0 produces them itself).
+ *   2. Layer 0 broadcasts its blocks to the other layers (replication).
+ *   3. Layer l runs the SUMMA steps for its share of the q block columns of
+ *      A / block rows of B, i.e. roughly q / c steps instead of q.
+ *   4. The partial C blocks are summed over the layers onto layer 0, which
+ *      sends them to rank 0 (or writes them to the output file).
+ *
+ * c = 1 is plain SUMMA. c = P^(1/3) gives q = c, the 3D algorithm where each
+ * layer does a single step. In between, the words moved per process shrink
+ * by about sqrt(c) while the memory per process grows by c.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <mpi.h>
+#include "algorithms.h"
+#include "grid.h"
+
+// Largest number of elements summed by one MPI_Reduce, see reduce_layers
+#ifndef REDUCE_CHUNK
+#define REDUCE_CHUNK (1 << 28)
+#endif
+
+typedef struct {
+    grid2d grid;                         // q x q grid of this layer
+    int layer;                           // which of the c layers this process is in
+    int c;                               // replication factor (number of layers)
+    MPI_Comm layer_comm;                 // processes in this layer
+    MPI_Comm depth_comm;                 // processes at the same (row, col) in every layer
+    void *local_A, *local_B, *local_C;   // the blocks owned by this process
+    void *panel_A, *panel_B;             // receive buffers for the broadcasts
+} summa25d_state;
+
+/**
+ * summa25d_setup
+ * --------------
+ * Splits the processes into c layers and builds the grid of each layer.
+ *
+ * Notes:
+ *   Layer l is made of world ranks l*q^2 to (l+1)*q^2 - 1, so layer 0 holds
+ *   rank 0 at position (0, 0) of its grid. Process (row, col) of layer l is
+ *   rank l of its depth communicator.
+ */
+int summa25d_setup(run_ctx *ctx) {
+    int c = ctx->replication;
+
+    if (ctx->size % c != 0) {
+        if (ctx->rank == 0) fprintf(stderr, "The 2.5d algorithm needs a number of processes divisible by the replication factor.\n");
+        return 1;
+    }
+    int layer_size = ctx->size / c;
+
+    summa25d_state *st = calloc(1, sizeof(summa25d_state));
+    if (!st) {
+        fprintf(stderr, "Memory allocation failed\n");
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+    st->c = c;
+    st->layer = ctx->rank / layer_size;
+
+    MPI_Comm_split(MPI_COMM_WORLD, st->layer, ctx->rank, &st->layer_comm);
+    MPI_Comm_split(MPI_COMM_WORLD, ctx->rank % layer_size, ctx->rank, &st->depth_comm);
+
+    // every layer has the same size, so all processes agree on the outcome
+    int bad = grid_init(&st->grid, st->layer_comm, ctx) != 0;
+    if (!bad && st->grid.q < c) {
+        grid_free(&st->grid);
+        bad = 1;
+    }
+    if (bad) {
+        if (ctx->rank == 0) {
+            fprintf(stderr, "The 2.5d algorithm needs P = c * q^2 processes with q >= c "
+                            "(P = %d, c = %d).\n", ctx->size, c);
+        }
+        MPI_Comm_free(&st->layer_comm);
+        MPI_Comm_free(&st->depth_comm);
+        free(st);
+        return 1;
+    }
+
+    st->local_A = grid_alloc_block(&st->grid, ctx->in_size);
+    st->local_B = grid_alloc_block(&st->grid, ctx->in_size);
+    st->local_C = grid_alloc_block(&st->grid, ctx->out_size);
+    st->panel_A = grid_alloc_block(&st->grid, ctx->in_size);
+    st->panel_B = grid_alloc_block(&st->grid, ctx->in_size);
+
+    ctx->priv = st;
+    return 0;
+}
+
+/**
+ * summa25d_load
+ * -------------
+ * Distributed input: layer 0 produces its blocks of A and B, the other
+ * layers get their copies from the replication step in run.
+ *
+ * Notes:
+ *   The other layers still call ctx->fill, for an empty block, so every
+ *   process makes the same fill calls.
+ */
+void summa25d_load(run_ctx *ctx) {
+    summa25d_state *st = ctx->priv;
+    grid2d *g = &st->grid;
+
+    if (st->layer == 0) {
+        grid_fill_block(g, ctx, MATRIX_A, st->local_A);
+        grid_fill_block(g, ctx, MATRIX_B, st->local_B);
+    } else {
+        ctx->fill(ctx, MATRIX_A, 0, 0, 0, 0, st->local_A, g->nb);
+        ctx->fill(ctx, MATRIX_B, 0, 0, 0, 0, st->local_B, g->nb);
+    }
+}
+
+/**
+ * reduce_layers
+ * -------------
+ * Sums a block over the layers onto layer 0, in place there.
+ *
+ * Notes:
+ *   MPI_SUM only works on predefined types, so unlike the other transfers
+ *   the block cannot be sent as nb rows of c_row_type. It is reduced in
+ *   chunks of whole rows of ctx->out_type instead, each at most
+ *   REDUCE_CHUNK elements (at least one row), which keeps every count well
+ *   inside an int.
+ */
+static void reduce_layers(const run_ctx *ctx, const summa25d_state *st, void *block) {
+    int nb = st->grid.nb;
+    int rows_per_chunk = nb < REDUCE_CHUNK ? REDUCE_CHUNK / nb : 1;
+
+    for (int r = 0; r < nb; r += rows_per_chunk) {
+        int rows = nb - r < rows_per_chunk ? nb - r : rows_per_chunk;
+        void *chunk = ELEM(block, (size_t)r * nb, ctx->out_size);
+        if (st->layer == 0) {
+            MPI_Reduce(MPI_IN_PLACE, chunk, rows * nb, ctx->out_type, MPI_SUM, 0, st->depth_comm);
+        } else {
+            MPI_Reduce(chunk, NULL, rows * nb, ctx->out_type, MPI_SUM, 0, st->depth_comm);
+        }
+    }
+}
+
+/**
+ * summa25d_run
+ * ------------
+ * Timed part: scatter to layer 0 (unless it loaded its own blocks),
+ * replicate over the layers, run this layer's SUMMA steps, reduce C onto
+ * layer 0 and gather it on rank 0 (unless layer 0 writes it to the output
+ * file itself).
+ */
+void summa25d_run(run_ctx *ctx) {
+    summa25d_state *st = ctx->priv;
+    grid2d *g = &st->grid;
+    int nb = g->nb;
+    size_t block_bytes = (size_t)nb * nb * ctx->in_size;
+    double t = MPI_Wtime();
+
+    if (st->layer == 0 && !ctx->distributed_input) {
+        ctx->bytes[PHASE_SCATTER] += grid_scatter_block(g, ctx->A, st->local_A);
+        ctx->bytes[PHASE_SCATTER] += grid_scatter_block(g, ctx->B, st->local_B);
+    }
+    phase_lap(ctx->times, PHASE_SCATTER, &t);
+    MPI_Bcast(st->local_A, nb, g->row_type, 0, st->depth_comm);
+    MPI_Bcast(st->local_B, nb, g->row_type, 0, st->depth_comm);
+    if (st->layer != 0) ctx->bytes[PHASE_BROADCAST] += 2 * block_bytes;
+    memset(st->local_C, 0, (size_t)nb * nb * ctx->out_size);
+    phase_lap(ctx->times, PHASE_BROADCAST, &t);
+
+    int rows = grid_extent(g, g->row);
+    int cols = grid_extent(g, g->col);
+
+    // this layer's share of the q SUMMA steps
+    int k_begin = st->layer * g->q / st->c;
+    int k_end = (st->layer + 1) * g->q / st->c;
+
+    for (int k = k_begin; k < k_end; k++) {
+        void *a = (g->col == k) ? st->local_A : st->panel_A;
+        void *b = (g->row == k) ? st->local_B : st->panel_B;
+
+        MPI_Bcast(a, nb, g->row_type, k, g->row_comm);
+        MPI_Bcast(b, nb, g->row_type, k, g->col_comm);
+        ctx->bytes[PHASE_BROADCAST] += (g->col != k) * block_bytes + (g->row != k) * block_bytes;
+        phase_lap(ctx->times, PHASE_BROADCAST, &t);
+
+        ctx->kernel->fn[ctx->precision](rows, cols, grid_extent(g, k), a, nb, b, nb, st->local_C, nb);
+        phase_lap(ctx->times, PHASE_COMPUTE, &t);
+    }
+
+    // sum the partial results of all layers into layer 0
+    reduce_layers(ctx, st, st->local_C);
+    if (st->layer == 0) {
+        ctx->bytes[PHASE_GATHER] += (st->c - 1) * ((size_t)nb * nb * ctx->out_size);
+        if (!ctx->distributed_output) ctx->bytes[PHASE_GATHER] += grid_gather_block(g, st->local_C, ctx->C);
+    }
+    phase_lap(ctx->times, PHASE_GATHER, &t);
+}
+
+/**
+ * summa25d_store
+ * --------------
+ * Distributed output: layer 0 holds the summed blocks of C and writes
+ * them, the other layers take part in the collective write without data.
+ */
+void summa25d_store(run_ctx *ctx, MPI_File fh) {
+    summa25d_state *st = ctx->priv;
+    grid2d *g = &st->grid;
+
+    if (st->layer == 0) {
+        grid_write_block(g, fh, st->local_C);
+    } else {
+        matio_write_block(fh, ctx->N, ctx->out_type, 0, 0, 0, 0, st->local_C, g->nb);
+    }
+}
+
+/**
+ * summa25d_tile
+ * -------------
+ * Tiles for --verify: layer 0 holds the original blocks of A and B and the
+ * summed blocks of C, the copies on the other layers are not reported.
+ */
+void summa25d_tile(const run_ctx *ctx, int matrix, matrix_tile *t) {
+    const summa25d_state *st = ctx->priv;
+    const void *block = matrix == MATRIX_A ? st->local_A :
+                        matrix == MATRIX_B ? st->local_B : st->local_C;
+
+    grid_block_tile(&st->grid, st->grid.row, st->grid.col, block,
+                    matrix == MATRIX_C ? ctx->out_size : ctx->in_size, t);
+    if (st->layer != 0) t->rows = t->cols = 0;
+}
+
+/**
+ * summa25d_cleanup
+ * ----------------
+ * Frees the blocks and all communicators.
+ */
+void summa25d_cleanup(run_ctx *ctx) {
+    summa25d_state *st = ctx->priv;
+
+    grid_free(&st->grid);
+    MPI_Comm_free(&st->layer_comm);
+    MPI_Comm_free(&st->depth_comm);
+    free(st->local_A); free(st->local_B); free(st->local_C);
+    free(st->panel_A); free(st->panel_B);
+    free(st);
+    ctx->priv = NULL;
+}
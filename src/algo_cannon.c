@@ -0,0 +1,189 @@
+/**
+ * Cannon's Algorithm
+ * Uses the same sqrt(P) x sqrt(P) block layout as SUMMA, but instead of
+ * broadcasts every process only exchanges blocks with its grid neighbours.
+ *
+ * After an initial skew (row i of A shifted left by i, column j of B
+ * shifted up by j) process (i, j) holds A(i, k) and B(k, j) for the same
+ * k = (i + j) mod q. It multiplies them, passes A one step left and B one
+ * step up, and after q steps has accumulated all of C(i, j).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <mpi.h>
+#include "algorithms.h"
+#include "grid.h"
+
+typedef struct {
+    grid2d grid;
+    void *local_A, *local_B, *local_C;   // the blocks currently held by this process
+    void *input_A, *input_B;             // blocks produced by load (distributed input)
+} cannon_state;
+
+/**
+ * cannon_setup
+ * ------------
+ * Builds the periodic process grid and allocates the three nb x nb blocks.
+ */
+int cannon_setup(run_ctx *ctx) {
+    cannon_state *st = calloc(1, sizeof(cannon_state));
+    if (!st) {
+        fprintf(stderr, "Memory allocation failed\n");
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+
+    if (grid_init(&st->grid, MPI_COMM_WORLD, ctx) != 0) {
+        if (ctx->rank == 0) fprintf(stderr, "The cannon algorithm needs a square number of processes.\n");
+        free(st);
+        return 1;
+    }
+
+    st->local_A = grid_alloc_block(&st->grid, ctx->in_size);
+    st->local_B = grid_alloc_block(&st->grid, ctx->in_size);
+    st->local_C = grid_alloc_block(&st->grid, ctx->out_size);
+
+    ctx->priv = st;
+    return 0;
+}
+
+/**
+ * shift_block
+ * -----------
+ * Cyclically shifts a block of A or B `disp` steps along grid dimension
+ * `dim` (0 = up/down a column, 1 = left/right along a row) in place.
+ *
+ * Notes:
+ *   MPI_Cart_shift returns the neighbours `disp` steps away with the grid
+ *   wrapping around, MPI_Sendrecv_replace sends the block to one and
+ *   receives the replacement from the other using a single buffer.
+ *
+ * Returns:
+ *   Number of bytes received, 0 if the block stays where it is.
+ */
+static size_t shift_block(const grid2d *g, void *block, int dim, int disp) {
+    if (disp % g->q == 0) return 0;
+
+    int source, dest;
+    MPI_Cart_shift(g->comm, dim, disp, &source, &dest);
+    MPI_Sendrecv_replace(block, g->nb, g->row_type, dest, 0, source, 0,
+                         g->comm, MPI_STATUS_IGNORE);
+    return (size_t)g->nb * g->nb * g->in_size;
+}
+
+/**
+ * cannon_load
+ * -----------
+ * Distributed input: every process produces its own blocks of A and B.
+ *
+ * Notes:
+ *   The shifts leave other blocks in local_A and local_B, so the loaded
+ *   blocks are kept apart and copied in at the start of every run.
+ */
+void cannon_load(run_ctx *ctx) {
+    cannon_state *st = ctx->priv;
+
+    st->input_A = grid_alloc_block(&st->grid, ctx->in_size);
+    st->input_B = grid_alloc_block(&st->grid, ctx->in_size);
+    grid_fill_block(&st->grid, ctx, MATRIX_A, st->input_A);
+    grid_fill_block(&st->grid, ctx, MATRIX_B, st->input_B);
+}
+
+/**
+ * cannon_run
+ * ----------
+ * Timed part: scatter the blocks of A and B from rank 0 (or start from
+ * the loaded ones), skew them, run
+ * the q multiply-and-shift steps and gather the blocks of C on rank 0
+ * (unless each process writes its own).
+ */
+void cannon_run(run_ctx *ctx) {
+    cannon_state *st = ctx->priv;
+    grid2d *g = &st->grid;
+    int nb = g->nb, q = g->q;
+    double t = MPI_Wtime();
+
+    if (ctx->distributed_input) {
+        memcpy(st->local_A, st->input_A, (size_t)nb * nb * ctx->in_size);
+        memcpy(st->local_B, st->input_B, (size_t)nb * nb * ctx->in_size);
+    } else {
+        ctx->bytes[PHASE_SCATTER] += grid_scatter_block(g, ctx->A, st->local_A);
+        ctx->bytes[PHASE_SCATTER] += grid_scatter_block(g, ctx->B, st->local_B);
+    }
+    memset(st->local_C, 0, (size_t)nb * nb * ctx->out_size);
+    phase_lap(ctx->times, PHASE_SCATTER, &t);
+
+    // initial skew: A(i, j) moves i steps left, B(i, j) moves j steps up
+    ctx->bytes[PHASE_BROADCAST] += shift_block(g, st->local_A, 1, -g->row);
+    ctx->bytes[PHASE_BROADCAST] += shift_block(g, st->local_B, 0, -g->col);
+    phase_lap(ctx->times, PHASE_BROADCAST, &t);
+
+    int rows = grid_extent(g, g->row);
+    int cols = grid_extent(g, g->col);
+
+    for (int step = 0; step < q; step++) {
+        // index of the A block column / B block row held during this step
+        int k = (g->row + g->col + step) % q;
+        ctx->kernel->fn[ctx->precision](rows, cols, grid_extent(g, k), st->local_A, nb,
+                        st->local_B, nb, st->local_C, nb);
+        phase_lap(ctx->times, PHASE_COMPUTE, &t);
+
+        // the blocks are not needed after the last step
+        if (step < q - 1) {
+            ctx->bytes[PHASE_BROADCAST] += shift_block(g, st->local_A, 1, -1);
+            ctx->bytes[PHASE_BROADCAST] += shift_block(g, st->local_B, 0, -1);
+        }
+        phase_lap(ctx->times, PHASE_BROADCAST, &t);
+    }
+
+    if (!ctx->distributed_output) ctx->bytes[PHASE_GATHER] += grid_gather_block(g, st->local_C, ctx->C);
+    phase_lap(ctx->times, PHASE_GATHER, &t);
+}
+
+/**
+ * cannon_store
+ * ------------
+ * Distributed output: every process writes its block of C.
+ */
+void cannon_store(run_ctx *ctx, MPI_File fh) {
+    cannon_state *st = ctx->priv;
+    grid_write_block(&st->grid, fh, st->local_C);
+}
+
+/**
+ * cannon_tile
+ * -----------
+ * Tiles for --verify. After run process (i, j) still holds the blocks of
+ * the last step, A(i, k) and B(k, j) with k = (i + j + q - 1) mod q. For a
+ * fixed i (or j) k runs over every block column (or row) once, so every
+ * block is held by exactly one process.
+ */
+void cannon_tile(const run_ctx *ctx, int matrix, matrix_tile *t) {
+    const cannon_state *st = ctx->priv;
+    const grid2d *g = &st->grid;
+    int k = (g->row + g->col + g->q - 1) % g->q;
+
+    if (matrix == MATRIX_A) {
+        grid_block_tile(g, g->row, k, st->local_A, ctx->in_size, t);
+    } else if (matrix == MATRIX_B) {
+        grid_block_tile(g, k, g->col, st->local_B, ctx->in_size, t);
+    } else {
+        grid_block_tile(g, g->row, g->col, st->local_C, ctx->out_size, t);
+    }
+}
+
+/**
+ * cannon_cleanup
+ * --------------
+ * Frees the blocks and the grid communicators.
+ */
+void cannon_cleanup(run_ctx *ctx) {
+    cannon_state *st = ctx->priv;
+
+    grid_free(&st->grid);
+    free(st->local_A); free(st->local_B); free(st->local_C);
+    free(st->input_A); free(st->input_B);
+    free(st);
+    ctx->priv = NULL;
+}
@@ -0,0 +1,231 @@
+/**
+ * Out-of-Core Matrix Multiplication
+ * For matrices that do not fit in the memory of the allocation: A, B and C
+ * stay in their binary files (--a, --b, --output) and every process only
+ * keeps a bounded working set of panels in memory.
+ *
+ * The rows of C are split between the processes as in the 1d algorithm,
+ * and each process works through its rows in panels of `rows` rows:
+ *   C(panel) = A(panel, :) * B = sum over k of A(panel, k panel) * B(k panel, :)
+ * The A panel is read once, B streams through in panels of `b_rows` rows
+ * (the whole of B once per A panel), and the finished C panel is written
+ * back. Whole rows are contiguous in the files, so every transfer is a
+ * single independent nonblocking MPI-IO call.
+ *
+ * Every buffer is doubled so the I/O hides behind the local multiply:
+ *   - the next B panel is read while the current one is multiplied,
+ *   - the next A panel is read while the current C panel is computed,
+ *   - the previous C panel is written while the next one is computed.
+ * The processes never talk to each other, they only share the files.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <mpi.h>
+#include "algorithms.h"
+
+// Rows of B per streamed panel, fewer when the memory budget is small
+#ifndef OOC_B_PANEL
+#define OOC_B_PANEL 256
+#endif
+
+#define MIN(a, b) ((a) < (b) ? (a) : (b))
+
+typedef struct {
+    int first_row, num_rows; // rows of C this process computes
+    int rows;                // rows of A and C per panel
+    int b_rows;              // rows of B per panel
+    void *A[2], *B[2], *C[2];
+} ooc_state;
+
+/**
+ * ooc_setup
+ * ---------
+ * Checks that A, B and C are files and sizes the panels to the memory
+ * budget ctx->memory.
+ *
+ * Notes:
+ *   The working set is two A and two C panels of `rows` x N elements and
+ *   two B panels of `b_rows` x N elements. B panels of OOC_B_PANEL rows are
+ *   enough for the kernels to run at full speed, everything else goes to
+ *   the A/C panels: B is read once per A panel, so taller panels mean
+ *   less I/O.
+ */
+int ooc_setup(run_ctx *ctx) {
+    int N = ctx->N;
+
+    if (ctx->input[MATRIX_A] == MPI_FILE_NULL || !ctx->output_file) {
+        if (ctx->rank == 0) fprintf(stderr, "The ooc algorithm needs --a, --b and --output, A, B and C stay in files.\n");
+        return 1;
+    }
+
+    // the budget in bytes, the same on every process: 2 B panels of b_rows
+    // rows of A/B elements, 2 A and 2 C panels of `rows` rows each
+    size_t in_row = (size_t)N * ctx->in_size, out_row = (size_t)N * ctx->out_size;
+    size_t budget = ctx->memory;
+    int b_rows = MIN(OOC_B_PANEL, N);
+    if (budget < 2 * (size_t)b_rows * in_row + 2 * (in_row + out_row)) {
+        b_rows = budget >= 4 * in_row + 2 * out_row ? (int)((budget - 2 * (in_row + out_row)) / (2 * in_row)) : 0;
+    }
+    size_t rows = b_rows > 0 ? (budget - 2 * (size_t)b_rows * in_row) / (2 * (in_row + out_row)) : 0;
+    if (b_rows < 1 || rows < 1) {
+        if (ctx->rank == 0) {
+            fprintf(stderr, "--memory is too small for the ooc algorithm, it needs at least %.3g MiB per process.\n",
+                    (4.0 * in_row + 2.0 * out_row) / (1 << 20));
+        }
+        return 1;
+    }
+
+    ooc_state *st = calloc(1, sizeof(ooc_state));
+    if (!st) {
+        fprintf(stderr, "Memory allocation failed\n");
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+    split_rows(N, ctx->size, ctx->rank, &st->first_row, &st->num_rows);
+    st->rows = (int)MIN(rows, (size_t)(st->num_rows > 0 ? st->num_rows : 1));
+    st->b_rows = b_rows;
+
+    for (int i = 0; i < 2; i++) {
+        st->A[i] = malloc((size_t)st->rows * in_row);
+        st->C[i] = malloc((size_t)st->rows * out_row);
+        st->B[i] = malloc((size_t)st->b_rows * in_row);
+        if (!st->A[i] || !st->B[i] || !st->C[i]) {
+            fprintf(stderr, "Memory allocation failed\n");
+            MPI_Abort(MPI_COMM_WORLD, 1);
+        }
+    }
+
+    ctx->priv = st;
+    return 0;
+}
+
+/**
+ * ooc_load
+ * --------
+ * Nothing to do: A and B are read panel by panel during run.
+ */
+void ooc_load(run_ctx *ctx) {
+    (void)ctx;
+}
+
+/**
+ * wait_io
+ * -------
+ * Waits for a file request, adds the wait to the file I/O phase.
+ */
+static void wait_io(run_ctx *ctx, MPI_Request *req, double *t) {
+    MPI_Wait(req, MPI_STATUS_IGNORE);
+    phase_lap(ctx->times, PHASE_FILE_IO, t);
+}
+
+/**
+ * ooc_run
+ * -------
+ * Timed part: streams this process's rows of C through memory.
+ *
+ * Notes:
+ *   - The B panels are numbered across all A panels (step s is B panel
+ *     s % num_k of A panel s / num_k), so the read of the first B panel of
+ *     the next A panel overlaps the last product of the current one.
+ *   - The file I/O phase only counts the time spent waiting for requests,
+ *     i.e. the part of the I/O that was not hidden. Its bytes are the
+ *     bytes read and written.
+ *   - After each product the next read gets an MPI_Test, for MPI libraries
+ *     that only make progress inside MPI calls.
+ */
+void ooc_run(run_ctx *ctx) {
+    ooc_state *st = ctx->priv;
+    int N = ctx->N;
+    MPI_File fa = ctx->input[MATRIX_A], fb = ctx->input[MATRIX_B], fc = ctx->output;
+    MPI_Datatype in = ctx->in_type, out = ctx->out_type;
+    MPI_Request a_req[2] = { MPI_REQUEST_NULL, MPI_REQUEST_NULL };
+    MPI_Request b_req[2] = { MPI_REQUEST_NULL, MPI_REQUEST_NULL };
+    MPI_Request c_req[2] = { MPI_REQUEST_NULL, MPI_REQUEST_NULL };
+    double t = MPI_Wtime();
+
+    int num_panels = (st->num_rows + st->rows - 1) / st->rows;
+    int num_k = (N + st->b_rows - 1) / st->b_rows;
+    long steps = (long)num_panels * num_k;
+    size_t in_row = (size_t)N * ctx->in_size, out_row = (size_t)N * ctx->out_size;
+
+    if (num_panels > 0) {
+        matio_iread_rows(fa, N, in, st->first_row, MIN(st->rows, st->num_rows), st->A[0], &a_req[0]);
+        matio_iread_rows(fb, N, in, 0, MIN(st->b_rows, N), st->B[0], &b_req[0]);
+    }
+
+    for (int p = 0; p < num_panels; p++) {
+        int r0 = st->first_row + p * st->rows;
+        int rows = MIN(st->rows, st->first_row + st->num_rows - r0);
+        void *a = st->A[p % 2], *c = st->C[p % 2];
+
+        // this A panel, then start the next one
+        wait_io(ctx, &a_req[p % 2], &t);
+        ctx->bytes[PHASE_FILE_IO] += (double)rows * in_row;
+        if (p + 1 < num_panels) {
+            int next = r0 + st->rows;
+            matio_iread_rows(fa, N, in, next, MIN(st->rows, st->first_row + st->num_rows - next),
+                             st->A[(p + 1) % 2], &a_req[(p + 1) % 2]);
+        }
+
+        // the C buffer is free once its write from two panels ago is done
+        wait_io(ctx, &c_req[p % 2], &t);
+        memset(c, 0, (size_t)rows * out_row);
+
+        for (int kk = 0; kk < num_k; kk++) {
+            long s = (long)p * num_k + kk;
+            int k0 = kk * st->b_rows, kb = MIN(st->b_rows, N - k0);
+            void *b = st->B[s % 2];
+
+            // this B panel, then start the next one (maybe for the next A panel)
+            wait_io(ctx, &b_req[s % 2], &t);
+            ctx->bytes[PHASE_FILE_IO] += (double)kb * in_row;
+            if (s + 1 < steps) {
+                int next = ((kk + 1) % num_k) * st->b_rows;
+                matio_iread_rows(fb, N, in, next, MIN(st->b_rows, N - next),
+                                 st->B[(s + 1) % 2], &b_req[(s + 1) % 2]);
+            }
+
+            // C panel (rows x N) += A(panel, k0:k0+kb) * B(k0:k0+kb, :)
+            ctx->kernel->fn[ctx->precision](rows, N, kb, ELEM(a, k0, ctx->in_size), N, b, N, c, N);
+            phase_lap(ctx->times, PHASE_COMPUTE, &t);
+
+            int flag;
+            MPI_Test(&b_req[(s + 1) % 2], &flag, MPI_STATUS_IGNORE);
+            phase_lap(ctx->times, PHASE_FILE_IO, &t);
+        }
+
+        matio_iwrite_rows(fc, N, out, r0, rows, c, &c_req[p % 2]);
+        ctx->bytes[PHASE_FILE_IO] += (double)rows * out_row;
+    }
+
+    MPI_Waitall(2, c_req, MPI_STATUSES_IGNORE);
+    phase_lap(ctx->times, PHASE_FILE_IO, &t);
+}
+
+/**
+ * ooc_store
+ * ---------
+ * Nothing to do: run already wrote every panel of C.
+ */
+void ooc_store(run_ctx *ctx, MPI_File fh) {
+    (void)ctx;
+    (void)fh;
+}
+
+/**
+ * ooc_cleanup
+ * -----------
+ * Frees the panel buffers.
+ */
+void ooc_cleanup(run_ctx *ctx) {
+    ooc_state *st = ctx->priv;
+
+    for (int i = 0; i < 2; i++) {
+        free(st->A[i]);
+        free(st->B[i]);
+        free(st->C[i]);
+    }
+    free(st);
+    ctx->priv = NULL;
+}
@@ -0,0 +1,151 @@
+/**
+ * SUMMA (Scalable Universal Matrix Multiplication Algorithm)
+ * The P processes form a sqrt(P) x sqrt(P) grid and process (i, j) owns
+ * block (i, j) of A, B and C, so each one holds only O(N^2 / P) elements.
+ *
+ * C(i, j) = sum over k of A(i, k) * B(k, j), computed in q steps. In step k
+ * the owners of block column k of A broadcast their block along their grid
+ * row, the owners of block row k of B broadcast theirs along their grid
+ * column, and every process adds the product of the two blocks it received
+ * to its block of C.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <mpi.h>
+#include "algorithms.h"
+#include "grid.h"
+
+typedef struct {
+    grid2d grid;
+    void *local_A, *local_B, *local_C;   // the blocks owned by this process
+    void *panel_A, *panel_B;             // receive buffers for the broadcasts
+} summa_state;
+
+/**
+ * summa_setup
+ * -----------
+ * Builds the process grid and allocates the five nb x nb blocks.
+ */
+int summa_setup(run_ctx *ctx) {
+    summa_state *st = calloc(1, sizeof(summa_state));
+    if (!st) {
+        fprintf(stderr, "Memory allocation failed\n");
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+
+    if (grid_init(&st->grid, MPI_COMM_WORLD, ctx) != 0) {
+        if (ctx->rank == 0) fprintf(stderr, "The summa algorithm needs a square number of processes.\n");
+        free(st);
+        return 1;
+    }
+
+    st->local_A = grid_alloc_block(&st->grid, ctx->in_size);
+    st->local_B = grid_alloc_block(&st->grid, ctx->in_size);
+    st->local_C = grid_alloc_block(&st->grid, ctx->out_size);
+    st->panel_A = grid_alloc_block(&st->grid, ctx->in_size);
+    st->panel_B = grid_alloc_block(&st->grid, ctx->in_size);
+
+    ctx->priv = st;
+    return 0;
+}
+
+/**
+ * summa_load
+ * ----------
+ * Distributed input: every process produces its own blocks of A and B.
+ */
+void summa_load(run_ctx *ctx) {
+    summa_state *st = ctx->priv;
+
+    grid_fill_block(&st->grid, ctx, MATRIX_A, st->local_A);
+    grid_fill_block(&st->grid, ctx, MATRIX_B, st->local_B);
+}
+
+/**
+ * summa_run
+ * ---------
+ * Timed part: scatter the blocks of A and B from rank 0 (unless each
+ * process loaded its own), run the q SUMMA steps and gather the blocks of
+ * C on rank 0 (unless each process writes its own).
+ *
+ * Notes:
+ *   Only the real part of each block is multiplied, so the padding of the
+ *   border blocks costs memory and bandwidth but no flops.
+ */
+void summa_run(run_ctx *ctx) {
+    summa_state *st = ctx->priv;
+    grid2d *g = &st->grid;
+    int nb = g->nb;
+    size_t block_bytes = (size_t)nb * nb * ctx->in_size;
+    double t = MPI_Wtime();
+
+    if (!ctx->distributed_input) {
+        ctx->bytes[PHASE_SCATTER] += grid_scatter_block(g, ctx->A, st->local_A);
+        ctx->bytes[PHASE_SCATTER] += grid_scatter_block(g, ctx->B, st->local_B);
+    }
+    memset(st->local_C, 0, (size_t)nb * nb * ctx->out_size);
+    phase_lap(ctx->times, PHASE_SCATTER, &t);
+
+    int rows = grid_extent(g, g->row);
+    int cols = grid_extent(g, g->col);
+
+    for (int k = 0; k < g->q; k++) {
+        // the owner broadcasts straight from its own block
+        void *a = (g->col == k) ? st->local_A : st->panel_A;
+        void *b = (g->row == k) ? st->local_B : st->panel_B;
+
+        // A(i, k) along grid row i, the root is the process in column k
+        MPI_Bcast(a, nb, g->row_type, k, g->row_comm);
+        // B(k, j) along grid column j, the root is the process in row k
+        MPI_Bcast(b, nb, g->row_type, k, g->col_comm);
+        ctx->bytes[PHASE_BROADCAST] += (g->col != k) * block_bytes + (g->row != k) * block_bytes;
+        phase_lap(ctx->times, PHASE_BROADCAST, &t);
+
+        ctx->kernel->fn[ctx->precision](rows, cols, grid_extent(g, k), a, nb, b, nb, st->local_C, nb);
+        phase_lap(ctx->times, PHASE_COMPUTE, &t);
+    }
+
+    if (!ctx->distributed_output) ctx->bytes[PHASE_GATHER] += grid_gather_block(g, st->local_C, ctx->C);
+    phase_lap(ctx->times, PHASE_GATHER, &t);
+}
+
+/**
+ * summa_store
+ * -----------
+ * Distributed output: every process writes its block of C.
+ */
+void summa_store(run_ctx *ctx, MPI_File fh) {
+    summa_state *st = ctx->priv;
+    grid_write_block(&st->grid, fh, st->local_C);
+}
+
+/**
+ * summa_tile
+ * ----------
+ * Tiles for --verify: the blocks owned by this process, the broadcasts
+ * only ever read them.
+ */
+void summa_tile(const run_ctx *ctx, int matrix, matrix_tile *t) {
+    const summa_state *st = ctx->priv;
+    const void *block = matrix == MATRIX_A ? st->local_A :
+                        matrix == MATRIX_B ? st->local_B : st->local_C;
+    grid_block_tile(&st->grid, st->grid.row, st->grid.col, block,
+                    matrix == MATRIX_C ? ctx->out_size : ctx->in_size, t);
+}
+
+/**
+ * summa_cleanup
+ * -------------
+ * Frees the blocks and the grid communicators.
+ */
+void summa_cleanup(run_ctx *ctx) {
+    summa_state *st = ctx->priv;
+
+    grid_free(&st->grid);
+    free(st->local_A); free(st->local_B); free(st->local_C);
+    free(st->panel_A); free(st->panel_B);
+    free(st);
+    ctx->priv = NULL;
+}
@@ -0,0 +1,63 @@
+/**
+ * Distributed Matrix Multiplication Algorithms
+ * Table of the algorithms selectable with --algo, see algorithms.h.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "algorithms.h"
+
+// Table of every algorithm selectable with --algo, the first entry is the default
+static const algorithm_info algorithms[] = {
+    { "1d",        "scatter rows of A, broadcast B to every process (default)",
+      rows_setup, rows_load, rows_run, rows_store, rows_tile, rows_cleanup },
+    { "shared",    "scatter rows of A, one copy of B per node in an MPI shared memory window",
+      rows_shared_setup, rows_load, rows_shared_run, rows_store, rows_tile, rows_cleanup },
+    { "pipelined", "scatter rows of A, broadcast B in panels with MPI_Ibcast overlapped with compute",
+      rows_setup, rows_load, rows_pipelined_run, rows_store, rows_tile, rows_cleanup },
+    { "summa",     "2D blocks on a sqrt(P) x sqrt(P) grid, row/column panel broadcasts",
+      summa_setup, summa_load, summa_run, summa_store, summa_tile, summa_cleanup },
+    { "cannon",    "2D blocks on a sqrt(P) x sqrt(P) grid, cyclic neighbour shifts",
+      cannon_setup, cannon_load, cannon_run, cannon_store, cannon_tile, cannon_cleanup },
+    { "2.5d",      "c layers of sqrt(P/c) x sqrt(P/c) grids, trades memory for communication",
+      summa25d_setup, summa25d_load, summa25d_run, summa25d_store, summa25d_tile, summa25d_cleanup },
+    { "ooc",       "out of core, A, B and C stay in files and stream through memory in row panels",
+      ooc_setup, ooc_load, ooc_run, ooc_store, NULL, ooc_cleanup },
+};
+
+#define NUM_ALGORITHMS (int)(sizeof(algorithms) / sizeof(algorithms[0]))
+
+/**
+ * find_algorithm
+ * --------------
+ * Looks up an algorithm by the name used on the command line.
+ *
+ * Returns:
+ *   Pointer to the matching algorithm_info, or NULL if there is none.
+ */
+const algorithm_info *find_algorithm(const char *name) {
+    for (int i = 0; i < NUM_ALGORITHMS; i++) {
+        if (strcmp(algorithms[i].name, name) == 0) return &algorithms[i];
+    }
+    return NULL;
+}
+
+/**
+ * default_algorithm
+ * -----------------
+ * Returns the algorithm used when --algo is not given.
+ */
+const algorithm_info *default_algorithm(void) {
+    return &algorithms[0];
+}
+
+/**
+ * print_algorithms
+ * ----------------
+ * Lists every algorithm with its description, one per line.
+ */
+void print_algorithms(FILE *f) {
+    for (int i = 0; i < NUM_ALGORITHMS; i++) {
+        fprintf(f, "    %-15s %s\n", algorithms[i].name, algorithms[i].description);
+    }
+}
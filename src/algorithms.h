@@ -0,0 +1,181 @@
+/**
+ * Distributed Matrix Multiplication Algorithms
+ * Each algorithm decides how A, B and C are spread over the processes and
+ * which messages are exchanged; the local work is done by a kernel from
+ * kernels.h. main() in matmul.c drives the algorithm through the hooks in
+ * algorithm_info.
+ */
+
+#ifndef ALGORITHMS_H
+#define ALGORITHMS_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <mpi.h>
+#include "kernels.h"
+#include "matio.h"
+#include "timing.h"
+
+// Which matrix a fill request (or, with C, a tile request) is for
+#define MATRIX_A 0
+#define MATRIX_B 1
+#define MATRIX_C 2
+
+// Address of element `index` of an array of `size` byte elements
+#define ELEM(ptr, index, size) ((char *)(ptr) + (size_t)(index) * (size))
+
+/**
+ * run_ctx
+ * -------
+ * State shared between main() and the algorithm for one program run.
+ */
+typedef struct run_ctx run_ctx;
+
+/**
+ * fill_fn
+ * -------
+ * Produces rows x cols elements of matrix A or B starting at global
+ * position (r0, c0), writing them to dst with ld elements between rows.
+ * Every process calls it once per matrix in the load hook, A first.
+ */
+typedef void (*fill_fn)(const run_ctx *ctx, int matrix, int r0, int c0,
+                        int rows, int cols, void *dst, int ld);
+
+struct run_ctx {
+    int N;                      // size of the matrices (NxN)
+    int rank, size;             // position in and size of MPI_COMM_WORLD
+    const kernel_info *kernel;  // local multiplication kernel
+    int replication;            // number of copies of A and B kept by the 2.5d algorithm
+
+    // Element types, see precision_info: A and B are stored in in_format
+    // with in_size bytes per element and travel as in_type, C likewise in
+    // out_format, out_size and out_type. The kernel to call is
+    // kernel->fn[precision].
+    int precision;
+    int in_format, out_format;
+    size_t in_size, out_size;
+    MPI_Datatype in_type, out_type;
+
+    // Full matrices. A and C only exist on rank 0. An algorithm that needs
+    // all of B on every rank allocates it in setup, otherwise main() only
+    // allocates B on rank 0. With distributed input rank 0 has no A (and
+    // no B of its own).
+    void *A, *B, *C;
+
+    // When distributed_input is set the processes produce their own parts
+    // of A and B with fill in the load hook, and run skips the scatter.
+    int distributed_input;
+    fill_fn fill;
+    uint64_t seed;              // seed of the random matrices
+    MPI_File input[2];          // files of A and B (indexed by MATRIX_A/B) when read from disk
+
+    // When distributed_output is set run leaves C spread over the
+    // processes (rank 0 has no C). With output_file (--output) the store
+    // hook then writes it to a file, without (--root-light alone) C is only
+    // there for --verify.
+    int distributed_output;
+    int output_file;
+    MPI_File output;            // that file, opened after setup, for algorithms that write C during run
+    size_t memory;              // bytes of working set per process for the ooc algorithm
+
+    double times[NUM_PHASES];   // seconds this process spent in each phase, see timing.h
+    double bytes[NUM_PHASES];   // bytes this process received in each phase
+
+    void *priv;                 // algorithm specific state
+};
+
+/**
+ * matrix_tile
+ * -----------
+ * A rows x cols part of a matrix held by one process, starting at global
+ * position (r0, c0), with ld elements of `size` bytes (the in_size or
+ * out_size of run_ctx) between its rows in memory.
+ */
+typedef struct {
+    int r0, c0;
+    int rows, cols;
+    const void *data;
+    int ld;
+    size_t size;
+} matrix_tile;
+
+/**
+ * algorithm_info
+ * --------------
+ * Hooks main() calls for an algorithm, in this order:
+ *   setup   - check the configuration and allocate local buffers. May set
+ *             ctx->B to a buffer it owns. Returns 0 on success; on failure
+ *             rank 0 has printed the reason and every rank returns non-zero.
+ *   load    - only with distributed input: every process fills its own
+ *             parts of A and B with ctx->fill, so nothing has to be
+ *             scattered from rank 0.
+ *   run     - the timed part: distribute A and B from rank 0 (or exchange
+ *             the parts each process loaded), multiply, and collect C on
+ *             rank 0 unless the output is distributed. Adds the time of
+ *             each step to ctx->times with phase_lap, and the bytes this
+ *             process received to ctx->bytes.
+ *   store   - only with an output file: every process writes its own part
+ *             of C to a file from matio_create.
+ *   tile    - after run, for --verify: the part of A, B or C (MATRIX_A/B/C)
+ *             this process holds. Every element is reported by exactly one
+ *             process, processes holding nothing report rows = 0. NULL for
+ *             an algorithm that does not keep the matrices in memory.
+ *   cleanup - free everything setup allocated, including an owned ctx->B.
+ */
+typedef struct {
+    const char *name;        // name used on the command line
+    const char *description; // one line shown in the usage message
+    int  (*setup)(run_ctx *ctx);
+    void (*load)(run_ctx *ctx);
+    void (*run)(run_ctx *ctx);
+    void (*store)(run_ctx *ctx, MPI_File fh);
+    void (*tile)(const run_ctx *ctx, int matrix, matrix_tile *t);
+    void (*cleanup)(run_ctx *ctx);
+} algorithm_info;
+
+// 1D row distribution (algo_1d.c)
+void split_rows(int n, int parts, int index, int *first, int *count);
+int  rows_setup(run_ctx *ctx);
+void rows_load(run_ctx *ctx);
+void rows_run(run_ctx *ctx);
+int  rows_shared_setup(run_ctx *ctx);
+void rows_shared_run(run_ctx *ctx);
+void rows_pipelined_run(run_ctx *ctx);
+void rows_store(run_ctx *ctx, MPI_File fh);
+void rows_tile(const run_ctx *ctx, int matrix, matrix_tile *t);
+void rows_cleanup(run_ctx *ctx);
+
+// Out of core, A, B and C stay in files (algo_ooc.c)
+int  ooc_setup(run_ctx *ctx);
+void ooc_load(run_ctx *ctx);
+void ooc_run(run_ctx *ctx);
+void ooc_store(run_ctx *ctx, MPI_File fh);
+void ooc_cleanup(run_ctx *ctx);
+
+// 2D block distribution (algo_summa.c, algo_cannon.c)
+int  summa_setup(run_ctx *ctx);
+void summa_load(run_ctx *ctx);
+void summa_run(run_ctx *ctx);
+void summa_store(run_ctx *ctx, MPI_File fh);
+void summa_tile(const run_ctx *ctx, int matrix, matrix_tile *t);
+void summa_cleanup(run_ctx *ctx);
+int  cannon_setup(run_ctx *ctx);
+void cannon_load(run_ctx *ctx);
+void cannon_run(run_ctx *ctx);
+void cannon_store(run_ctx *ctx, MPI_File fh);
+void cannon_tile(const run_ctx *ctx, int matrix, matrix_tile *t);
+void cannon_cleanup(run_ctx *ctx);
+
+// 2.5D replicated block distribution (algo_25d.c)
+int  summa25d_setup(run_ctx *ctx);
+void summa25d_load(run_ctx *ctx);
+void summa25d_run(run_ctx *ctx);
+void summa25d_store(run_ctx *ctx, MPI_File fh);
+void summa25d_tile(const run_ctx *ctx, int matrix, matrix_tile *t);
+void summa25d_cleanup(run_ctx *ctx);
+
+const algorithm_info *find_algorithm(const char *name);
+const algorithm_info *default_algorithm(void);
+void print_algorithms(FILE *f);
+
+#endif
@@ -0,0 +1,146 @@
+/**
+ * Element Formats
+ * The formats the elements of A, B and C can be stored in. The values
+ * double as the element type codes of the binary files (see matio.h).
+ *
+ * bfloat16 and IEEE half are storage formats only: they are converted to
+ * float before any arithmetic. bfloat16 is the top half of a float, so the
+ * conversion to float is a shift; half has its own exponent range and is
+ * converted with the F16C instructions when the compiler targets them.
+ */
+
+#ifndef ELEM_H
+#define ELEM_H
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#ifdef __F16C__
+#include <immintrin.h>
+#endif
+
+#define ELEM_FLOAT32  1  // float
+#define ELEM_FLOAT64  2  // double
+#define ELEM_BFLOAT16 3  // bfloat16: 8 exponent bits, 7 mantissa bits
+#define ELEM_FLOAT16  4  // IEEE half: 5 exponent bits, 10 mantissa bits
+
+/**
+ * bf16_to_float / float_to_bf16
+ * -----------------------------
+ * Conversions between float and bfloat16 (stored as its bits).
+ *
+ * Notes:
+ *   float_to_bf16 rounds to nearest even, NaNs stay NaNs.
+ */
+static inline float bf16_to_float(uint16_t b) {
+    uint32_t u = (uint32_t)b << 16;
+    float f;
+    memcpy(&f, &u, sizeof(f));
+    return f;
+}
+
+static inline uint16_t float_to_bf16(float f) {
+    uint32_t u;
+    memcpy(&u, &f, sizeof(u));
+    if ((u & 0x7fffffff) > 0x7f800000) return (uint16_t)((u >> 16) | 0x40);
+    return (uint16_t)((u + 0x7fff + ((u >> 16) & 1)) >> 16);
+}
+
+/**
+ * fp16_to_float / float_to_fp16
+ * -----------------------------
+ * Conversions between float and IEEE half (stored as its bits).
+ *
+ * Notes:
+ *   - float_to_fp16 rounds to nearest even. Values that round past the
+ *     largest half (65504) become infinity, tiny values become subnormal
+ *     halves or 0.
+ *   - Without F16C both are done with integer operations, which gives the
+ *     same results, only slower.
+ */
+static inline float fp16_to_float(uint16_t h) {
+#ifdef __F16C__
+    return _cvtsh_ss(h);
+#else
+    uint32_t sign = (uint32_t)(h & 0x8000) << 16;
+    uint32_t exp = (h >> 10) & 0x1f, mant = h & 0x3ff;
+    uint32_t u;
+    if (exp == 0) {
+        // 0 or subnormal: mant * 2^-24 is exact in float
+        float f = (float)mant * 0x1p-24f;
+        return sign ? -f : f;
+    }
+    if (exp == 0x1f) {
+        u = sign | 0x7f800000 | (mant << 13);  // infinity or NaN
+    } else {
+        u = sign | ((exp + 112) << 23) | (mant << 13);
+    }
+    float f;
+    memcpy(&f, &u, sizeof(f));
+    return f;
+#endif
+}
+
+static inline uint16_t float_to_fp16(float f) {
+#ifdef __F16C__
+    return _cvtss_sh(f, _MM_FROUND_TO_NEAREST_INT);
+#else
+    uint32_t u;
+    memcpy(&u, &f, sizeof(u));
+    uint16_t sign = (uint16_t)((u >> 16) & 0x8000);
+    uint32_t a = u & 0x7fffffff;
+    if (a >= 0x7f800000) return sign | 0x7c00 | (a > 0x7f800000 ? 0x200 : 0);
+    if (a >= 0x477ff000) return sign | 0x7c00;  // 65520 and up round to infinity
+    if (a < 0x38800000) {
+        // below 2^-14 the half is subnormal, its bits are round(|f| * 2^24)
+        return sign | (uint16_t)lrintf(fabsf(f) * 0x1p24f);
+    }
+    // rebias the exponent and round away the 13 extra mantissa bits
+    uint32_t r = a + 0xfff + ((a >> 13) & 1);
+    return sign | (uint16_t)((r - 0x38000000) >> 13);
+#endif
+}
+
+/**
+ * elem_size
+ * ---------
+ * Bytes per element of a format.
+ */
+static inline size_t elem_size(int format) {
+    switch (format) {
+    case ELEM_FLOAT64:  return sizeof(double);
+    case ELEM_BFLOAT16:
+    case ELEM_FLOAT16:  return sizeof(uint16_t);
+    default:            return sizeof(float);
+    }
+}
+
+/**
+ * elem_load / elem_store
+ * ----------------------
+ * Reads or writes element i of an array of `format` elements.
+ *
+ * Notes:
+ *   For the setup and checking code, not for inner loops. elem_store
+ *   rounds v to the format.
+ */
+static inline double elem_load(const void *p, size_t i, int format) {
+    switch (format) {
+    case ELEM_FLOAT64:  return ((const double *)p)[i];
+    case ELEM_BFLOAT16: return bf16_to_float(((const uint16_t *)p)[i]);
+    case ELEM_FLOAT16:  return fp16_to_float(((const uint16_t *)p)[i]);
+    default:            return ((const float *)p)[i];
+    }
+}
+
+static inline void elem_store(void *p, size_t i, int format, double v) {
+    switch (format) {
+    case ELEM_FLOAT64:  ((double *)p)[i] = v; break;
+    case ELEM_BFLOAT16: ((uint16_t *)p)[i] = float_to_bf16((float)v); break;
+    case ELEM_FLOAT16:  ((uint16_t *)p)[i] = float_to_fp16((float)v); break;
+    default:            ((float *)p)[i] = (float)v; break;
+    }
+}
+
+#endif
@@ -0,0 +1,86 @@
+/**
+ * Loop Matrix Multiplication Kernels
+ * The plain and the cache-blocked loop kernels. Like gemm_packed.c this
+ * file is compiled once per precision (see gemm_precision.h), producing
+ * matmul_naive_<precision> and matmul_blocked_<precision>.
+ */
+
+#include <stddef.h>
+#include "kernels.h"
+#include "gemm_precision.h"
+
+#define MIN(a, b) ((a) < (b) ? (a) : (b))
+
+#define matmul_naive GEMM_KERNEL(matmul_naive)
+#define matmul_blocked GEMM_KERNEL(matmul_blocked)
+
+/**
+ * matmul_naive
+ * ------------
+ * The textbook i-k-j triple loop.
+ *
+ * Notes:
+ *   - The k loop sits outside the j loop so B and C are walked along rows,
+ *     which is contiguous in row-major order.
+ *   - Every row of A streams all of B through the cache, so for large N
+ *     this kernel is limited by memory bandwidth, not by the FPU.
+ *   - With OpenMP the rows of C are split between the threads.
+ */
+void matmul_naive(int M, int N, int K, const void *A_in, int lda,
+                  const void *B_in, int ldb, void *C_out, int ldc) {
+    const gemm_in_t *A = A_in, *B = B_in;
+    gemm_t *C = C_out;
+
+    #pragma omp parallel for schedule(static)
+    for (int i = 0; i < M; i++) {
+        for (int k = 0; k < K; k++) {
+            for (int j = 0; j < N; j++) {
+                C[(size_t)i * ldc + j] += GEMM_LOAD(A[(size_t)i * lda + k]) * GEMM_LOAD(B[(size_t)k * ldb + j]);
+            }
+        }
+    }
+}
+
+/**
+ * matmul_blocked
+ * --------------
+ * Cache-blocked version of matmul_naive.
+ *
+ * Notes:
+ *   - The outer loops walk BLOCK_N wide column tiles (jj), BLOCK_K deep
+ *     tiles of B (kk) and BLOCK_M tall tiles of A (ii). The inner i-k-j
+ *     loops then only touch a tile of B that is already in cache.
+ *   - For every element of C the k sum still runs from 0 to K-1 in order,
+ *     so the result is the same as matmul_naive.
+ *   - With OpenMP the BLOCK_M row tiles are split between the threads. A
+ *     static schedule hands every thread the same tiles for each (jj, kk),
+ *     so no thread touches another one's rows and no barrier is needed.
+ */
+void matmul_blocked(int M, int N, int K, const void *A_in, int lda,
+                    const void *B_in, int ldb, void *C_out, int ldc) {
+    const gemm_in_t *A = A_in, *B = B_in;
+    gemm_t *C = C_out;
+
+    #pragma omp parallel
+    for (int jj = 0; jj < N; jj += BLOCK_N) {
+        int j_end = MIN(jj + BLOCK_N, N);
+        for (int kk = 0; kk < K; kk += BLOCK_K) {
+            int k_end = MIN(kk + BLOCK_K, K);
+            #pragma omp for schedule(static) nowait
+            for (int ii = 0; ii < M; ii += BLOCK_M) {
+                int i_end = MIN(ii + BLOCK_M, M);
+
+                for (int i = ii; i < i_end; i++) {
+                    gemm_t *c_row = C + (size_t)i * ldc;
+                    for (int k = kk; k < k_end; k++) {
+                        const gemm_t a = GEMM_LOAD(A[(size_t)i * lda + k]);
+                        const gemm_in_t *b_row = B + (size_t)k * ldb;
+                        for (int j = jj; j < j_end; j++) {
+                            c_row[j] += a * GEMM_LOAD(b_row[j]);
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,266 @@
+/**
+ * Packed-Panel Matrix Multiplication (GotoBLAS/BLIS style)
+ *
+ * C += A * B is computed in three layers of blocking:
+ *   - B is cut into PACK_KC x PACK_NC blocks that are copied ("packed") into a
+ *     contiguous buffer sized for L3, laid out as PACK_NR wide column panels.
+ *   - A is cut into PACK_MC x PACK_KC blocks packed into an L2 sized buffer,
+ *     laid out as PACK_MR tall row panels.
+ *   - A microkernel multiplies one A panel by one B panel, keeping the whole
+ *     PACK_MR x PACK_NR tile of C in vector registers for the full k loop.
+ *
+ * The microkernel is written with GCC/Clang vector extensions so the same
+ * source builds an AVX-512, AVX2 or plain 128-bit SSE/NEON version depending
+ * on the compiler flags. Without any SIMD unit the compiler lowers the vector
+ * operations to scalar code, which serves as the portable fallback.
+ *
+ * The Makefile compiles this file once per instruction set and precision
+ * with -DGEMM_ISA=<isa> -DGEMM_PRECISION=<precision>, producing
+ * matmul_packed_<isa>_<precision>. kernels.c picks the instruction set at
+ * run time based on what the CPU supports.
+ *
+ * The panels and the microkernel work in gemm_t, the type C is summed in
+ * (see gemm_precision.h). In mixed mode packing converts the float A and B
+ * to double on the way into the panels, so the conversion costs one pass
+ * over each block and the microkernel is the same as in double. The bf16
+ * and fp16 modes work the same way with the float microkernel: bfloat16 is
+ * widened with a shift the compiler vectorizes, half with the F16C
+ * instructions the AVX builds are compiled with.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "kernels.h"
+#include "gemm_precision.h"
+
+#if defined(__AVX512F__)
+#define VEC_BYTES 64    // 16 floats (8 doubles) per zmm register
+#define PACK_MR 12      // 12 x 2 vector tile: 24 accumulators out of 32 registers
+#elif defined(__AVX2__) && defined(__FMA__)
+#define VEC_BYTES 32    // 8 floats (4 doubles) per ymm register
+#define PACK_MR 6       // 6 x 2 vector tile: 12 accumulators out of 16 registers
+#else
+#define VEC_BYTES 16    // 4 floats (2 doubles) per xmm/NEON register, or scalar code
+#define PACK_MR 6       // 6 x 2 vector tile: 12 accumulators out of 16 registers
+#endif
+
+#define VEC_LEN (VEC_BYTES / (int)sizeof(gemm_t))
+#define PACK_NV 2                       // vectors per row of the C tile
+#define PACK_NR (PACK_NV * VEC_LEN)
+
+// Cache blocking, kept multiples of the register tile
+#define PACK_KC 256                     // depth of a packed panel
+#define PACK_MC (PACK_MR * 20)          // rows of A packed at once (L2)
+#define PACK_NC (PACK_NR * 128)         // columns of B packed at once (L3)
+
+#define MIN(a, b) ((a) < (b) ? (a) : (b))
+
+#ifndef GEMM_ISA
+#define GEMM_ISA generic
+#endif
+#define matmul_packed GEMM_KERNEL(GEMM_NAME(matmul_packed, GEMM_ISA))
+#define matmul_blocked GEMM_KERNEL(matmul_blocked)
+
+typedef gemm_t vreal __attribute__((vector_size(VEC_BYTES)));
+
+/**
+ * pack_A_panel
+ * ------------
+ * Copies mr (<= PACK_MR) rows and kc columns of A into one row panel,
+ * converting them to gemm_t.
+ *
+ * Notes:
+ *   Inside a panel the PACK_MR values of one column of A are contiguous, so
+ *   the microkernel reads A strictly sequentially. Rows past mr are zero.
+ */
+static void pack_A_panel(int mr, int kc, const gemm_in_t *A, int lda, gemm_t *Ap) {
+    for (int p = 0; p < kc; p++) {
+        for (int i = 0; i < mr; i++) {
+            Ap[i] = GEMM_LOAD(A[(size_t)i * lda + p]);
+        }
+        for (int i = mr; i < PACK_MR; i++) {
+            Ap[i] = 0;
+        }
+        Ap += PACK_MR;
+    }
+}
+
+/**
+ * pack_B_panel
+ * ------------
+ * Copies kc rows and nr (<= PACK_NR) columns of B into one column panel,
+ * converting them to gemm_t.
+ *
+ * Notes:
+ *   - Inside a panel each row of PACK_NR values is contiguous and vector
+ *     aligned. Columns past nr are zero.
+ *   - The compiler does not vectorize the scalar half conversion, so with
+ *     F16C the rows of an fp16 B are converted 8 values at a time.
+ */
+static void pack_B_panel(int kc, int nr, const gemm_in_t *B, int ldb, gemm_t *Bp) {
+    for (int p = 0; p < kc; p++) {
+        const gemm_in_t *b_row = B + (size_t)p * ldb;
+        int j = 0;
+#if defined(GEMM_PRECISION_fp16) && defined(__F16C__)
+        for (; j + 8 <= nr; j += 8) {
+            __m128i h = _mm_loadu_si128((const __m128i *)(b_row + j));
+            _mm256_storeu_ps(Bp + j, _mm256_cvtph_ps(h));
+        }
+#endif
+        for (; j < nr; j++) {
+            Bp[j] = GEMM_LOAD(b_row[j]);
+        }
+        for (int j = nr; j < PACK_NR; j++) {
+            Bp[j] = 0;
+        }
+        Bp += PACK_NR;
+    }
+}
+
+/**
+ * microkernel
+ * -----------
+ * Computes a full PACK_MR x PACK_NR tile: C += Ap * Bp.
+ *
+ * Parameters:
+ *   kc  - depth of the panels
+ *   Ap  - packed A panel (kc columns of PACK_MR values)
+ *   Bp  - packed B panel (kc rows of PACK_NR values, vector aligned)
+ *   C   - top left element of the tile, ldc is the distance between rows
+ *
+ * Notes:
+ *   The accumulators stay in registers for the whole k loop. Every step
+ *   loads PACK_NV vectors of B, broadcasts PACK_MR values of A and issues
+ *   PACK_MR * PACK_NV fused multiply-adds.
+ */
+static inline void microkernel(int kc, const gemm_t *restrict Ap,
+                               const gemm_t *restrict Bp,
+                               gemm_t *restrict C, int ldc) {
+    vreal acc[PACK_MR][PACK_NV];
+    for (int i = 0; i < PACK_MR; i++) {
+        for (int v = 0; v < PACK_NV; v++) {
+            acc[i][v] = (vreal){ 0 };
+        }
+    }
+
+    const vreal *b = (const vreal *)Bp;
+    for (int p = 0; p < kc; p++) {
+        vreal b_vec[PACK_NV];
+        for (int v = 0; v < PACK_NV; v++) {
+            b_vec[v] = b[v];
+        }
+        for (int i = 0; i < PACK_MR; i++) {
+            const gemm_t a = Ap[i];
+            for (int v = 0; v < PACK_NV; v++) {
+                acc[i][v] += a * b_vec[v];
+            }
+        }
+        Ap += PACK_MR;
+        b += PACK_NV;
+    }
+
+    // C is not aligned in general, memcpy compiles to unaligned loads/stores
+    for (int i = 0; i < PACK_MR; i++) {
+        for (int v = 0; v < PACK_NV; v++) {
+            vreal c;
+            gemm_t *dst = C + (size_t)i * ldc + v * VEC_LEN;
+            memcpy(&c, dst, sizeof(c));
+            c += acc[i][v];
+            memcpy(dst, &c, sizeof(c));
+        }
+    }
+}
+
+/**
+ * microkernel_edge
+ * ----------------
+ * Handles tiles on the bottom/right border that are smaller than
+ * PACK_MR x PACK_NR by running the microkernel on a scratch tile.
+ */
+static void microkernel_edge(int kc, int mr, int nr, const gemm_t *Ap,
+                             const gemm_t *Bp, gemm_t *C, int ldc) {
+    gemm_t tile[PACK_MR * PACK_NR] __attribute__((aligned(VEC_BYTES))) = { 0 };
+    microkernel(kc, Ap, Bp, tile, PACK_NR);
+    for (int i = 0; i < mr; i++) {
+        for (int j = 0; j < nr; j++) {
+            C[(size_t)i * ldc + j] += tile[i * PACK_NR + j];
+        }
+    }
+}
+
+/**
+ * matmul_packed
+ * -------------
+ * C[M x N] += A[M x K] * B[K x N] using packed panels and the SIMD
+ * microkernel. See the top of this file for the blocking scheme.
+ *
+ * Notes:
+ *   When built with OpenMP all threads share the packed blocks of A and B:
+ *   they pack the panels of a block together, wait at the barrier that ends
+ *   the omp for, and then split the microkernel calls over (jr, ir) so every
+ *   thread has work even when M is small.
+ */
+void matmul_packed(int M, int N, int K, const void *A_in, int lda,
+                   const void *B_in, int ldb, void *C_out, int ldc) {
+    const gemm_in_t *A = A_in, *B = B_in;
+    gemm_t *C = C_out;
+    if (M <= 0 || N <= 0 || K <= 0) return;
+
+    // panels are read with aligned vector loads, so allocate them aligned
+    gemm_t *Ap = aligned_alloc(64, sizeof(gemm_t) * PACK_MC * PACK_KC);
+    gemm_t *Bp = aligned_alloc(64, sizeof(gemm_t) * PACK_KC * PACK_NC);
+    if (!Ap || !Bp) {
+        // not enough memory for the panels, fall back to the unpacked kernel
+        free(Ap); free(Bp);
+        matmul_blocked(M, N, K, A, lda, B, ldb, C, ldc);
+        return;
+    }
+
+    #pragma omp parallel
+    for (int jc = 0; jc < N; jc += PACK_NC) {
+        int nc = MIN(PACK_NC, N - jc);
+        int n_panels = (nc + PACK_NR - 1) / PACK_NR;
+        for (int pc = 0; pc < K; pc += PACK_KC) {
+            int kc = MIN(PACK_KC, K - pc);
+
+            #pragma omp for schedule(static)
+            for (int jp = 0; jp < n_panels; jp++) {
+                int jr = jp * PACK_NR;
+                pack_B_panel(kc, MIN(PACK_NR, nc - jr), B + (size_t)pc * ldb + jc + jr,
+                             ldb, Bp + (size_t)jr * kc);
+            }
+
+            for (int ic = 0; ic < M; ic += PACK_MC) {
+                int mc = MIN(PACK_MC, M - ic);
+                int m_panels = (mc + PACK_MR - 1) / PACK_MR;
+
+                #pragma omp for schedule(static)
+                for (int ip = 0; ip < m_panels; ip++) {
+                    int ir = ip * PACK_MR;
+                    pack_A_panel(MIN(PACK_MR, mc - ir), kc, A + (size_t)(ic + ir) * lda + pc,
+                                 lda, Ap + (size_t)ir * kc);
+                }
+
+                #pragma omp for collapse(2) schedule(static)
+                for (int jp = 0; jp < n_panels; jp++) {
+                    for (int ip = 0; ip < m_panels; ip++) {
+                        int jr = jp * PACK_NR, ir = ip * PACK_MR;
+                        int nr = MIN(PACK_NR, nc - jr);
+                        int mr = MIN(PACK_MR, mc - ir);
+                        const gemm_t *b_panel = Bp + (size_t)jr * kc;
+                        const gemm_t *a_panel = Ap + (size_t)ir * kc;
+                        gemm_t *c_tile = C + (size_t)(ic + ir) * ldc + jc + jr;
+                        if (mr == PACK_MR && nr == PACK_NR) {
+                            microkernel(kc, a_panel, b_panel, c_tile, ldc);
+                        } else {
+                            microkernel_edge(kc, mr, nr, a_panel, b_panel, c_tile, ldc);
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    free(Ap);
+    free(Bp);
+}
@@ -0,0 +1,62 @@
+/**
+ * Element Types of the Kernels
+ * gemm_loops.c and gemm_packed.c are written once and compiled once per
+ * precision with -DGEMM_PRECISION=<float|double|mixed|bf16|fp16> (see the
+ * Makefile),
+ * so every precision gets exactly the same loops and blocking. This header
+ * turns the precision into the two types the kernel sources use:
+ *   gemm_in_t - the elements of A and B, as the caller stores them
+ *   gemm_t    - the elements of C, and the type every product is summed in
+ * and GEMM_LOAD(x), which turns an element of A or B into a gemm_t.
+ *
+ * In mixed mode A and B stay float while C is double. The product of two
+ * floats is exact in double, so C only carries the rounding of the double
+ * sums, and A and B take half the memory and bandwidth of double.
+ *
+ * In the bf16 and fp16 modes A and B are stored as bfloat16 or IEEE half
+ * bits (see elem.h) and C is float, so A and B take half the memory and
+ * bandwidth of float. The products are formed and summed in float.
+ *
+ * GEMM_KERNEL(name) appends the precision to a kernel name, the names
+ * kernels.h declares with KERNEL_VARIANTS.
+ */
+
+#ifndef GEMM_PRECISION_H
+#define GEMM_PRECISION_H
+
+#ifndef GEMM_PRECISION
+#define GEMM_PRECISION float
+#define GEMM_PRECISION_float
+#endif
+
+#include <stdint.h>
+#include "elem.h"
+
+#if defined(GEMM_PRECISION_double)
+typedef double gemm_in_t;
+typedef double gemm_t;
+#elif defined(GEMM_PRECISION_mixed)
+typedef float gemm_in_t;
+typedef double gemm_t;
+#elif defined(GEMM_PRECISION_bf16)
+typedef uint16_t gemm_in_t;
+typedef float gemm_t;
+#define GEMM_LOAD(x) bf16_to_float(x)
+#elif defined(GEMM_PRECISION_fp16)
+typedef uint16_t gemm_in_t;
+typedef float gemm_t;
+#define GEMM_LOAD(x) fp16_to_float(x)
+#else
+typedef float gemm_in_t;
+typedef float gemm_t;
+#endif
+
+#ifndef GEMM_LOAD
+#define GEMM_LOAD(x) ((gemm_t)(x))
+#endif
+
+#define GEMM_NAME_(name, suffix) name##_##suffix
+#define GEMM_NAME(name, suffix) GEMM_NAME_(name, suffix)
+#define GEMM_KERNEL(name) GEMM_NAME(name, GEMM_PRECISION)
+
+#endif
@@ -0,0 +1,233 @@
+/**
+ * 2D Process Grid
+ * See grid.h for the block layout.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <mpi.h>
+#include "grid.h"
+#include "matio.h"
+
+#define MIN(a, b) ((a) < (b) ? (a) : (b))
+#define MAX(a, b) ((a) > (b) ? (a) : (b))
+
+/**
+ * grid_init
+ * ---------
+ * Arranges the processes of comm in a q x q periodic grid.
+ *
+ * Parameters:
+ *   g    - grid to fill in
+ *   comm - communicator with a square number of processes
+ *   ctx  - the run, for the size of the matrices and their element types
+ *
+ * Returns:
+ *   0 on success, 1 if the size of comm is not a square number.
+ *
+ * Notes:
+ *   The grid is not reordered, so rank r of comm sits at (r / q, r % q) and
+ *   rank 0, which holds the full matrices, owns block (0, 0).
+ */
+int grid_init(grid2d *g, MPI_Comm comm, const run_ctx *ctx) {
+    int N = ctx->N, size;
+    MPI_Comm_size(comm, &size);
+
+    int q = (int)lround(sqrt((double)size));
+    if (q * q != size) return 1;
+
+    g->N = N;
+    g->q = q;
+    g->nb = (N - 1) / q + 1;    // ceil(N / q) without overflowing for huge N
+
+    int dims[2] = { q, q };
+    int periods[2] = { 1, 1 };
+    MPI_Cart_create(comm, 2, dims, periods, 0, &g->comm);
+
+    int rank, coords[2];
+    MPI_Comm_rank(g->comm, &rank);
+    MPI_Cart_coords(g->comm, rank, 2, coords);
+    g->row = coords[0];
+    g->col = coords[1];
+
+    // keep the column dimension for the row communicator and vice versa
+    int keep_col[2] = { 0, 1 };
+    int keep_row[2] = { 1, 0 };
+    MPI_Cart_sub(g->comm, keep_col, &g->row_comm);
+    MPI_Cart_sub(g->comm, keep_row, &g->col_comm);
+
+    g->in_size = ctx->in_size;
+    g->out_size = ctx->out_size;
+    g->out_type = ctx->out_type;
+    MPI_Type_contiguous(g->nb, ctx->in_type, &g->row_type);
+    MPI_Type_commit(&g->row_type);
+    MPI_Type_contiguous(g->nb, ctx->out_type, &g->c_row_type);
+    MPI_Type_commit(&g->c_row_type);
+    return 0;
+}
+
+/**
+ * grid_free
+ * ---------
+ * Frees the communicators and the datatypes created by grid_init.
+ */
+void grid_free(grid2d *g) {
+    MPI_Type_free(&g->row_type);
+    MPI_Type_free(&g->c_row_type);
+    MPI_Comm_free(&g->row_comm);
+    MPI_Comm_free(&g->col_comm);
+    MPI_Comm_free(&g->comm);
+}
+
+/**
+ * grid_extent
+ * -----------
+ * Number of real (not padding) rows in block row `index`, which is the
+ * same as the number of real columns in block column `index`.
+ */
+int grid_extent(const grid2d *g, int index) {
+    return MAX(0, MIN(g->nb, g->N - index * g->nb));
+}
+
+/**
+ * grid_alloc_block
+ * ----------------
+ * Allocates one nb x nb block of `size` byte elements (g->in_size for A
+ * and B, g->out_size for C) filled with 0's, aborting if out of memory.
+ */
+void *grid_alloc_block(const grid2d *g, size_t size) {
+    void *block = calloc((size_t)g->nb * g->nb, size);
+    if (!block) {
+        fprintf(stderr, "Memory allocation failed\n");
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+    return block;
+}
+
+/**
+ * copy_block
+ * ----------
+ * Copies block (bi, bj) between the full N x N matrix and an nb x nb
+ * buffer, both with `size` byte elements. Padding in the buffer is set to
+ * 0 when copying into it.
+ */
+static void copy_block(const grid2d *g, int bi, int bj, void *full, void *block,
+                       size_t size, int to_block) {
+    int rows = grid_extent(g, bi), cols = grid_extent(g, bj);
+    int nb = g->nb;
+
+    if (to_block && (rows < nb || cols < nb)) {
+        memset(block, 0, (size_t)nb * nb * size);
+    }
+    for (int i = 0; i < rows; i++) {
+        char *full_row = ELEM(full, (size_t)(bi * nb + i) * g->N + (size_t)bj * nb, size);
+        char *block_row = ELEM(block, (size_t)i * nb, size);
+        if (to_block) {
+            memcpy(block_row, full_row, cols * size);
+        } else {
+            memcpy(full_row, block_row, cols * size);
+        }
+    }
+}
+
+/**
+ * grid_scatter_block
+ * ------------------
+ * Sends block (r, c) of the full matrix A or B on rank 0 to process (r, c).
+ *
+ * Parameters:
+ *   full  - N x N matrix, only read on rank 0 of the grid
+ *   block - nb x nb buffer that receives this process's block
+ *
+ * Returns:
+ *   Number of bytes this process received.
+ *
+ * Notes:
+ *   Blocks are not contiguous in the full matrix and the padded border
+ *   blocks differ in shape, so rank 0 copies each block into a contiguous
+ *   buffer and sends it with a plain MPI_Send.
+ */
+size_t grid_scatter_block(const grid2d *g, const void *full, void *block) {
+    int rank;
+    MPI_Comm_rank(g->comm, &rank);
+
+    if (rank == 0) {
+        void *tmp = grid_alloc_block(g, g->in_size);
+        for (int r = 1; r < g->q * g->q; r++) {
+            copy_block(g, r / g->q, r % g->q, (void *)full, tmp, g->in_size, 1);
+            MPI_Send(tmp, g->nb, g->row_type, r, 0, g->comm);
+        }
+        free(tmp);
+        copy_block(g, 0, 0, (void *)full, block, g->in_size, 1);
+        return 0;
+    }
+    MPI_Recv(block, g->nb, g->row_type, 0, 0, g->comm, MPI_STATUS_IGNORE);
+    return (size_t)g->nb * g->nb * g->in_size;
+}
+
+/**
+ * grid_gather_block
+ * -----------------
+ * Collects block (r, c) of C from every process (r, c) into the full
+ * matrix on rank 0. The padding of each block is dropped.
+ *
+ * Returns:
+ *   Number of bytes this process received (0 except on rank 0).
+ */
+size_t grid_gather_block(const grid2d *g, const void *block, void *full) {
+    int rank;
+    MPI_Comm_rank(g->comm, &rank);
+
+    if (rank == 0) {
+        void *tmp = grid_alloc_block(g, g->out_size);
+        copy_block(g, 0, 0, full, (void *)block, g->out_size, 0);
+        for (int r = 1; r < g->q * g->q; r++) {
+            MPI_Recv(tmp, g->nb, g->c_row_type, r, 0, g->comm, MPI_STATUS_IGNORE);
+            copy_block(g, r / g->q, r % g->q, full, tmp, g->out_size, 0);
+        }
+        free(tmp);
+        return (size_t)(g->q * g->q - 1) * g->nb * g->nb * g->out_size;
+    }
+    MPI_Send(block, g->nb, g->c_row_type, 0, 0, g->comm);
+    return 0;
+}
+
+/**
+ * grid_fill_block
+ * ---------------
+ * Produces this process's block of matrix A or B with ctx->fill, for
+ * algorithms with distributed input. The padding keeps its 0's.
+ */
+void grid_fill_block(const grid2d *g, const run_ctx *ctx, int matrix, void *block) {
+    ctx->fill(ctx, matrix, g->row * g->nb, g->col * g->nb,
+              grid_extent(g, g->row), grid_extent(g, g->col), block, g->nb);
+}
+
+/**
+ * grid_write_block
+ * ----------------
+ * Collective over the grid: writes the real part of this process's block
+ * of C to its place in a matrix file.
+ */
+void grid_write_block(const grid2d *g, MPI_File fh, const void *block) {
+    matio_write_block(fh, g->N, g->out_type, g->row * g->nb, g->col * g->nb,
+                      grid_extent(g, g->row), grid_extent(g, g->col), block, g->nb);
+}
+
+/**
+ * grid_block_tile
+ * ---------------
+ * Describes the real part of block (bi, bj), held in `block` with `size`
+ * byte elements, as a tile.
+ */
+void grid_block_tile(const grid2d *g, int bi, int bj, const void *block, size_t size, matrix_tile *t) {
+    t->r0 = bi * g->nb;
+    t->c0 = bj * g->nb;
+    t->rows = grid_extent(g, bi);
+    t->cols = grid_extent(g, bj);
+    t->data = block;
+    t->ld = g->nb;
+    t->size = size;
+}
@@ -0,0 +1,48 @@
+/**
+ * 2D Process Grid
+ * Helpers shared by the algorithms that split the matrices into a q x q
+ * grid of blocks (SUMMA, Cannon, 2.5D). Process (row, col) of the grid owns
+ * block (row, col) of A, B and C.
+ *
+ * When q does not divide N the blocks are padded to nb = ceil(N / q) rows
+ * and columns. The padding is filled with 0's so it does not change the
+ * product, and grid_extent tells the kernels how much of a block is real.
+ *
+ * Blocks are sent as nb rows of row_type (nb elements of A or B) or
+ * c_row_type (nb elements of C), so the int counts MPI takes stay small
+ * even when a block holds more than 2^31 elements. The two differ in mixed
+ * precision, where C is double and A and B are float.
+ */
+
+#ifndef GRID_H
+#define GRID_H
+
+#include <stddef.h>
+#include <mpi.h>
+#include "algorithms.h"
+
+typedef struct {
+    int N;                   // size of the full matrices
+    int q;                   // the grid is q x q processes
+    int nb;                  // padded block size, ceil(N / q)
+    int row, col;            // coordinates of this process in the grid
+    MPI_Comm comm;           // q x q periodic Cartesian communicator
+    MPI_Comm row_comm;       // processes in the same grid row, ranked by column
+    MPI_Comm col_comm;       // processes in the same grid column, ranked by row
+    size_t in_size, out_size; // bytes per element of A/B and of C, from run_ctx
+    MPI_Datatype out_type;   // element type of C, for the output file
+    MPI_Datatype row_type;   // one row of a block of A or B, nb elements
+    MPI_Datatype c_row_type; // one row of a block of C, nb elements
+} grid2d;
+
+int  grid_init(grid2d *g, MPI_Comm comm, const run_ctx *ctx);
+void grid_free(grid2d *g);
+int  grid_extent(const grid2d *g, int index);
+void *grid_alloc_block(const grid2d *g, size_t size);
+size_t grid_scatter_block(const grid2d *g, const void *full, void *block);
+size_t grid_gather_block(const grid2d *g, const void *block, void *full);
+void grid_fill_block(const grid2d *g, const run_ctx *ctx, int matrix, void *block);
+void grid_write_block(const grid2d *g, MPI_File fh, const void *block);
+void grid_block_tile(const grid2d *g, int bi, int bj, const void *block, size_t size, matrix_tile *t);
+
+#endif
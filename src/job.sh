@@ -19,4 +19,8 @@ module load mvapich2/2.3.7-1
 cd $SLURM_SUBMIT_DIR
 
 # Compile + run extralarge matrix
-make run MPI_LAUNCH="srun" MATRIX_SIZE=16384
\ No newline at end of file
+make run MPI_LAUNCH="srun" MATRIX_SIZE=16384
+
+# To size --ntasks, sweep 1..16 processes in this allocation instead
+# make strong-scaling MPI_LAUNCH="srun" STRONG_SIZE=8192
+# make weak-scaling MPI_LAUNCH="srun"
\ No newline at end of file
@@ -0,0 +1,31 @@
+#!/bin/bash
+#SBATCH --job-name=matmul_hybrid
+
+# One MPI rank per node that uses every core through OpenMP threads,
+# so each node holds a single copy of B instead of one per core
+#SBATCH --nodes=1
+#SBATCH --ntasks-per-node=1
+#SBATCH --cpus-per-task=16
+#SBATCH --mem=128G
+#SBATCH --time=1:00:00
+
+#SBATCH --output=matmul_%j.out
+#SBATCH --error=matmul_%j.err
+
+# Clean environment
+module purge
+module load gcc/12.3.0
+module load mvapich2/2.3.7-1
+
+# Go to directory where you ran sbatch
+cd $SLURM_SUBMIT_DIR
+
+# One thread per allocated core, kept on its own core
+export OMP_NUM_THREADS=$SLURM_CPUS_PER_TASK
+export OMP_PLACES=cores
+export OMP_PROC_BIND=close
+# newer Slurm versions do not pass --cpus-per-task on to srun by themselves
+export SRUN_CPUS_PER_TASK=$SLURM_CPUS_PER_TASK
+
+# Compile + run extralarge matrix
+make run MPI_LAUNCH="srun" MATRIX_SIZE=16384
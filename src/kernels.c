@@ -0,0 +1,254 @@
+/**
+ * Local Matrix Multiplication Kernels
+ * See kernels.h for the calling convention shared by every kernel. The
+ * kernels themselves are in gemm_loops.c and gemm_packed.c, this file holds
+ * the tables of kernels and precisions.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#include "kernels.h"
+
+// size and repetitions of the product timed by measure_kernel_gflops
+#define PEAK_SIZE 512
+#define PEAK_REPEAT 3
+
+/**
+ * cpu_has_avx2 / cpu_has_avx512
+ * -----------------------------
+ * Runtime checks used to pick a packed kernel variant.
+ *
+ * Notes:
+ *   - __builtin_cpu_supports reads the cpuid feature bits (and checks that the
+ *     OS saves the wider registers), so the answer describes the node the
+ *     program is running on, not the node it was compiled on.
+ *   - The AVX builds also use F16C for the fp16 precision. Every CPU with
+ *     AVX2 has it, the check is only there to be safe.
+ */
+#if defined(GEMM_HAVE_AVX2)
+static int cpu_has_avx2(void) {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma") &&
+           __builtin_cpu_supports("f16c");
+}
+#endif
+
+#if defined(GEMM_HAVE_AVX512)
+static int cpu_has_avx512(void) {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx512f") && cpu_has_avx2();
+}
+#endif
+
+// The builds of a kernel, indexed by precision
+#define KERNEL_FNS(name) { name##_float, name##_double, name##_mixed, name##_bf16, name##_fp16 }
+
+// Table of every kernel selectable with --kernel.
+// The packed variants are listed fastest first, "packed" picks the first one the CPU supports.
+static const kernel_info kernels[] = {
+#if defined(GEMM_HAVE_AVX512)
+    { "packed-avx512",  KERNEL_FNS(matmul_packed_avx512),  "packed panels, 12x32 AVX-512 microkernel (12x16 in double)", cpu_has_avx512 },
+#endif
+#if defined(GEMM_HAVE_AVX2)
+    { "packed-avx2",    KERNEL_FNS(matmul_packed_avx2),    "packed panels, 6x16 AVX2+FMA microkernel (6x8 in double)", cpu_has_avx2 },
+#endif
+    { "packed-generic", KERNEL_FNS(matmul_packed_generic), "packed panels, 6x8 128-bit/scalar microkernel (6x4 in double)", NULL },
+    { "blocked",        KERNEL_FNS(matmul_blocked),        "cache-blocked i-k-j loops", NULL },
+    { "naive",          KERNEL_FNS(matmul_naive),          "plain i-k-j triple loop", NULL },
+};
+
+#define NUM_KERNELS (int)(sizeof(kernels) / sizeof(kernels[0]))
+
+/**
+ * kernel_supported
+ * ----------------
+ * Returns non-zero if the CPU running this process can execute the kernel.
+ */
+int kernel_supported(const kernel_info *k) {
+    return k->supported == NULL || k->supported();
+}
+
+/**
+ * find_kernel
+ * -----------
+ * Looks up a kernel by the name used on the command line.
+ *
+ * Returns:
+ *   Pointer to the matching kernel_info, or NULL if there is none.
+ *   "packed" resolves to the fastest packed variant supported by this CPU.
+ *
+ * Notes:
+ *   An explicitly named variant is returned even if the CPU cannot run it,
+ *   callers should check kernel_supported before using it.
+ */
+const kernel_info *find_kernel(const char *name) {
+    int dispatch = strcmp(name, "packed") == 0;
+    for (int i = 0; i < NUM_KERNELS; i++) {
+        if (dispatch) {
+            if (strncmp(kernels[i].name, "packed-", 7) == 0 && kernel_supported(&kernels[i])) {
+                return &kernels[i];
+            }
+        } else if (strcmp(kernels[i].name, name) == 0) {
+            return &kernels[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * default_kernel
+ * --------------
+ * Returns the kernel used when --kernel is not given.
+ */
+const kernel_info *default_kernel(void) {
+    return find_kernel("packed");
+}
+
+/**
+ * kernel_threads
+ * --------------
+ * Number of threads the kernels run with in each process.
+ *
+ * Notes:
+ *   Without OpenMP the kernels are single threaded. With OpenMP this is
+ *   OMP_NUM_THREADS, or the value set by set_kernel_threads.
+ */
+int kernel_threads(void) {
+#ifdef _OPENMP
+    return omp_get_max_threads();
+#else
+    return 1;
+#endif
+}
+
+/**
+ * set_kernel_threads
+ * ------------------
+ * Sets the number of threads used by the kernels.
+ *
+ * Returns:
+ *   0 on success, 1 if more than one thread is requested in a build
+ *   without OpenMP.
+ */
+int set_kernel_threads(int threads) {
+#ifdef _OPENMP
+    omp_set_num_threads(threads);
+    return 0;
+#else
+    return threads == 1 ? 0 : 1;
+#endif
+}
+
+/**
+ * print_kernels
+ * -------------
+ * Lists every available kernel with its description, one per line.
+ */
+void print_kernels(FILE *f) {
+    fprintf(f, "    %-15s %s\n", "packed", "fastest packed variant this CPU supports (default)");
+    for (int i = 0; i < NUM_KERNELS; i++) {
+        fprintf(f, "    %-15s %s%s\n", kernels[i].name, kernels[i].description,
+                kernel_supported(&kernels[i]) ? "" : " [not supported on this CPU]");
+    }
+}
+
+// Table of every precision selectable with --precision, in PRECISION_* order, the first entry is the default
+static const precision_info precisions[] = {
+    { PRECISION_FLOAT,  "float",  ELEM_FLOAT32,  ELEM_FLOAT32, sizeof(float),    sizeof(float),  "float A, B and C (default)" },
+    { PRECISION_DOUBLE, "double", ELEM_FLOAT64,  ELEM_FLOAT64, sizeof(double),   sizeof(double), "double A, B and C" },
+    { PRECISION_MIXED,  "mixed",  ELEM_FLOAT32,  ELEM_FLOAT64, sizeof(float),    sizeof(double), "float A and B, C summed and stored in double" },
+    { PRECISION_BF16,   "bf16",   ELEM_BFLOAT16, ELEM_FLOAT32, sizeof(uint16_t), sizeof(float),  "bfloat16 A and B, C summed and stored in float" },
+    { PRECISION_FP16,   "fp16",   ELEM_FLOAT16,  ELEM_FLOAT32, sizeof(uint16_t), sizeof(float),  "IEEE half A and B, C summed and stored in float" },
+};
+
+/**
+ * find_precision
+ * --------------
+ * Looks up a precision by the name used on the command line.
+ *
+ * Returns:
+ *   Pointer to the matching precision_info, or NULL if there is none.
+ */
+const precision_info *find_precision(const char *name) {
+    for (int i = 0; i < NUM_PRECISIONS; i++) {
+        if (strcmp(precisions[i].name, name) == 0) return &precisions[i];
+    }
+    return NULL;
+}
+
+/**
+ * default_precision
+ * -----------------
+ * Returns the precision used when --precision is not given.
+ */
+const precision_info *default_precision(void) {
+    return &precisions[PRECISION_FLOAT];
+}
+
+/**
+ * print_precisions
+ * ----------------
+ * Lists every precision with its description, one per line.
+ */
+void print_precisions(FILE *f) {
+    for (int i = 0; i < NUM_PRECISIONS; i++) {
+        fprintf(f, "    %-15s %s\n", precisions[i].name, precisions[i].description);
+    }
+}
+
+/**
+ * measure_kernel_gflops
+ * ---------------------
+ * Measures the speed of a kernel on one core, as a practical stand-in for
+ * the peak of a core when none is given.
+ *
+ * Returns:
+ *   Best GFLOP/s of PEAK_REPEAT single threaded PEAK_SIZE^3 products in
+ *   the given precision, or 0 if the buffers could not be allocated.
+ *
+ * Notes:
+ *   The matrices (3 MiB in float) are small enough for the caches, so this
+ *   is what the kernel reaches without waiting on memory. It is not the
+ *   hardware peak, but comparing runs against it shows how much is lost to
+ *   communication and memory traffic.
+ */
+double measure_kernel_gflops(const kernel_info *k, const precision_info *prec) {
+    size_t count = (size_t)PEAK_SIZE * PEAK_SIZE;
+    void *A = malloc(count * prec->in_size);
+    void *B = malloc(count * prec->in_size);
+    void *C = malloc(count * prec->out_size);
+    if (!A || !B || !C) {
+        fprintf(stderr, "Memory allocation failed\n");
+        free(A); free(B); free(C);
+        return 0.0;
+    }
+    for (size_t i = 0; i < count; i++) {
+        elem_store(A, i, prec->in_format, (double)(i % 7) - 3.0);
+        elem_store(B, i, prec->in_format, (double)(i % 5) - 2.0);
+    }
+
+    int threads = kernel_threads();
+    set_kernel_threads(1);
+
+    double best = 0.0;
+    for (int r = 0; r < PEAK_REPEAT; r++) {
+        struct timespec t0, t1;
+        memset(C, 0, count * prec->out_size);
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        k->fn[prec->id](PEAK_SIZE, PEAK_SIZE, PEAK_SIZE, A, PEAK_SIZE, B, PEAK_SIZE, C, PEAK_SIZE);
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+
+        double seconds = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) * 1e-9;
+        double gflops = 2.0 * PEAK_SIZE * PEAK_SIZE * PEAK_SIZE / seconds / 1e9;
+        if (gflops > best) best = gflops;
+    }
+
+    set_kernel_threads(threads);
+    free(A); free(B); free(C);
+    return best;
+}
@@ -0,0 +1,135 @@
+/**
+ * Local Matrix Multiplication Kernels
+ * Every kernel computes C += A * B on row-major blocks that live in the
+ * memory of a single process. The MPI code in matmul.c decides which rows
+ * (or blocks) each process owns and then hands them to one of these kernels.
+ */
+
+#ifndef KERNELS_H
+#define KERNELS_H
+
+#include <stddef.h>
+#include <stdio.h>
+#include "elem.h"
+
+/**
+ * Cache blocking parameters for matmul_blocked (in elements).
+ *   BLOCK_N - width of a column tile of B and C; one row of a C tile
+ *             (BLOCK_N elements) stays in L1 while it is being updated.
+ *   BLOCK_K - depth of a tile of B; a BLOCK_K x BLOCK_N tile of B (256 KiB
+ *             of floats with the defaults) stays in L2 and is reused by
+ *             every row.
+ *   BLOCK_M - height of a tile of A; a BLOCK_M x BLOCK_K tile of A plus
+ *             the B tile fit comfortably in a shared L3 slice.
+ * They can be overridden at compile time, e.g. CFLAGS+=-DBLOCK_K=128.
+ */
+#ifndef BLOCK_M
+#define BLOCK_M 64
+#endif
+#ifndef BLOCK_N
+#define BLOCK_N 256
+#endif
+#ifndef BLOCK_K
+#define BLOCK_K 256
+#endif
+
+/**
+ * Precisions
+ * ----------
+ * Element types of a run, selected with --precision. Every kernel exists
+ * once per precision (see gemm_precision.h).
+ *   PRECISION_FLOAT  - A, B and C in float
+ *   PRECISION_DOUBLE - A, B and C in double
+ *   PRECISION_MIXED  - A and B in float, C summed and stored in double
+ *   PRECISION_BF16   - A and B in bfloat16, C summed and stored in float
+ *   PRECISION_FP16   - A and B in IEEE half, C summed and stored in float
+ */
+enum {
+    PRECISION_FLOAT,
+    PRECISION_DOUBLE,
+    PRECISION_MIXED,
+    PRECISION_BF16,
+    PRECISION_FP16,
+    NUM_PRECISIONS
+};
+
+typedef struct {
+    int id;                  // PRECISION_*
+    const char *name;        // name used on the command line
+    int in_format;           // element format of A and B, ELEM_* from elem.h
+    int out_format;          // element format of C
+    size_t in_size;          // bytes per element of A and B
+    size_t out_size;         // bytes per element of C
+    const char *description; // one line shown in the usage message
+} precision_info;
+
+/**
+ * matmul_kernel_fn
+ * ----------------
+ * Signature shared by all local kernels: C[M x N] += A[M x K] * B[K x N].
+ *
+ * Parameters:
+ *   M, N, K - dimensions of the product
+ *   A, lda  - pointer to A and the distance (in elements) between its rows
+ *   B, ldb  - pointer to B and the distance between its rows
+ *   C, ldc  - pointer to C and the distance between its rows
+ *
+ * Notes:
+ *   - Kernels accumulate into C, so C must be initialized (usually to 0's).
+ *   - The element types depend on the precision the kernel was built for,
+ *     hence the void pointers: in_size bytes per element of A and B,
+ *     out_size bytes per element of C.
+ */
+typedef void (*matmul_kernel_fn)(int M, int N, int K,
+                                 const void *A, int lda,
+                                 const void *B, int ldb,
+                                 void *C, int ldc);
+
+typedef struct {
+    const char *name;                     // name used on the command line
+    matmul_kernel_fn fn[NUM_PRECISIONS];  // the kernel itself, per precision
+    const char *description;              // one line shown in the usage message
+    int (*supported)(void);               // runtime CPU check, NULL if it runs everywhere
+} kernel_info;
+
+// Declares the builds of a kernel for every precision
+#define KERNEL_VARIANTS(name) \
+    void name##_float(int M, int N, int K, const void *A, int lda, \
+                      const void *B, int ldb, void *C, int ldc); \
+    void name##_double(int M, int N, int K, const void *A, int lda, \
+                       const void *B, int ldb, void *C, int ldc); \
+    void name##_mixed(int M, int N, int K, const void *A, int lda, \
+                      const void *B, int ldb, void *C, int ldc); \
+    void name##_bf16(int M, int N, int K, const void *A, int lda, \
+                     const void *B, int ldb, void *C, int ldc); \
+    void name##_fp16(int M, int N, int K, const void *A, int lda, \
+                     const void *B, int ldb, void *C, int ldc);
+
+// gemm_loops.c, compiled once per precision
+KERNEL_VARIANTS(matmul_naive)
+KERNEL_VARIANTS(matmul_blocked)
+
+/**
+ * Packed kernel variants
+ * ----------------------
+ * gemm_packed.c is compiled once per instruction set and precision (see
+ * the Makefile), every build appends its GEMM_ISA and precision to the
+ * name of matmul_packed. The AVX variants only exist on x86-64 builds
+ * (GEMM_HAVE_AVX2/GEMM_HAVE_AVX512).
+ */
+KERNEL_VARIANTS(matmul_packed_generic)
+KERNEL_VARIANTS(matmul_packed_avx2)
+KERNEL_VARIANTS(matmul_packed_avx512)
+
+const kernel_info *find_kernel(const char *name);
+int kernel_supported(const kernel_info *k);
+int kernel_threads(void);
+int set_kernel_threads(int threads);
+const kernel_info *default_kernel(void);
+void print_kernels(FILE *f);
+const precision_info *find_precision(const char *name);
+const precision_info *default_precision(void);
+void print_precisions(FILE *f);
+double measure_kernel_gflops(const kernel_info *k, const precision_info *prec);
+
+#endif
@@ -0,0 +1,349 @@
+/**
+ * Binary Matrix Files
+ * See matio.h for the file format.
+ */
+
+#include <limits.h>
+#include <stdio.h>
+#include <string.h>
+#include <mpi.h>
+#include "matio.h"
+
+// MPI datatypes of the 16-bit element types, created by matio_type
+static MPI_Datatype half_types[2] = { MPI_DATATYPE_NULL, MPI_DATATYPE_NULL };
+
+/**
+ * matio_type
+ * ----------
+ * MPI datatype of an element type code (MATIO_FLOAT32 ...), the type the
+ * other functions take.
+ *
+ * Notes:
+ *   MPI has no bfloat16 or half type. Both travel as their 16 bits, but as
+ *   two duplicates of MPI_UINT16_T, so the datatype still tells which of
+ *   the two a file holds. They are created on first use and freed by
+ *   MPI_Finalize.
+ */
+MPI_Datatype matio_type(int32_t dtype) {
+    switch (dtype) {
+    case MATIO_FLOAT64:
+        return MPI_DOUBLE;
+    case MATIO_BFLOAT16:
+    case MATIO_FLOAT16: {
+        MPI_Datatype *t = &half_types[dtype - MATIO_BFLOAT16];
+        if (*t == MPI_DATATYPE_NULL) {
+            MPI_Type_dup(MPI_UINT16_T, t);
+            MPI_Type_set_name(*t, dtype == MATIO_BFLOAT16 ? "bfloat16" : "float16");
+        }
+        return *t;
+    }
+    default:
+        return MPI_FLOAT;
+    }
+}
+
+/**
+ * type_size / file_dtype / dtype_name
+ * -----------------------------------
+ * Bytes per element, header code and name of an element type.
+ */
+static MPI_Offset type_size(MPI_Datatype type) {
+    int size;
+    MPI_Type_size(type, &size);
+    return size;
+}
+
+static int32_t file_dtype(MPI_Datatype type) {
+    if (type == MPI_DOUBLE) return MATIO_FLOAT64;
+    if (type == half_types[0]) return MATIO_BFLOAT16;
+    if (type == half_types[1]) return MATIO_FLOAT16;
+    return MATIO_FLOAT32;
+}
+
+static const char *dtype_name(int32_t dtype) {
+    switch (dtype) {
+    case MATIO_FLOAT32:  return "float32";
+    case MATIO_FLOAT64:  return "float64";
+    case MATIO_BFLOAT16: return "bfloat16";
+    case MATIO_FLOAT16:  return "float16";
+    default:             return "unknown";
+    }
+}
+
+/**
+ * matio_create
+ * ------------
+ * Collectively creates (or truncates) the file at path and writes the
+ * header of an N x N matrix of `type` elements.
+ *
+ * Returns:
+ *   0 on success, 1 if the file could not be opened. All processes return
+ *   the same value, rank 0 prints the reason.
+ *
+ * Notes:
+ *   The file is sized to hold the whole matrix right away, so an old longer
+ *   file does not leave stale data at the end.
+ */
+int matio_create(const char *path, int N, MPI_Datatype type, MPI_File *fh) {
+    int rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+    int err = MPI_File_open(MPI_COMM_WORLD, path, MPI_MODE_CREATE | MPI_MODE_WRONLY,
+                            MPI_INFO_NULL, fh);
+    if (err != MPI_SUCCESS) {
+        if (rank == 0) {
+            char msg[MPI_MAX_ERROR_STRING];
+            int len;
+            MPI_Error_string(err, msg, &len);
+            fprintf(stderr, "Failed to open %s for writing: %s\n", path, msg);
+        }
+        return 1;
+    }
+    MPI_File_set_size(*fh, MATIO_HEADER_SIZE + (MPI_Offset)N * N * type_size(type));
+
+    if (rank == 0) {
+        matio_header h;
+        memset(&h, 0, sizeof(h));
+        memcpy(h.magic, MATIO_MAGIC, sizeof(MATIO_MAGIC));
+        h.rows = N;
+        h.cols = N;
+        h.dtype = file_dtype(type);
+        h.layout = MATIO_ROW_MAJOR;
+        MPI_File_write_at(*fh, 0, &h, sizeof(h), MPI_BYTE, MPI_STATUS_IGNORE);
+    }
+    return 0;
+}
+
+/**
+ * matio_write_rows
+ * ----------------
+ * Collective: every process writes its consecutive rows of the matrix.
+ *
+ * Parameters:
+ *   fh        - file from matio_create
+ *   N         - size of the matrix (NxN)
+ *   first_row - global index of the first row written by this process
+ *   rows      - number of rows written by this process (may be 0)
+ *   data      - the rows, rows x N elements
+ *
+ * Notes:
+ *   Whole rows are contiguous in the file, so this is a single
+ *   MPI_File_write_at_all at the offset of the first row. The count is in
+ *   rows of N elements, rows * N may not fit in an int.
+ */
+void matio_write_rows(MPI_File fh, int N, MPI_Datatype type, int first_row, int rows, const void *data) {
+    MPI_Offset offset = MATIO_HEADER_SIZE + (MPI_Offset)first_row * N * type_size(type);
+    MPI_Datatype row_type;
+    MPI_Type_contiguous(N, type, &row_type);
+    MPI_Type_commit(&row_type);
+    MPI_File_write_at_all(fh, offset, data, rows, row_type, MPI_STATUS_IGNORE);
+    MPI_Type_free(&row_type);
+}
+
+/**
+ * matio_write_block
+ * -----------------
+ * Collective: every process writes its rows x cols block of the matrix
+ * whose top left element is at global position (r0, c0).
+ *
+ * Parameters:
+ *   fh     - file from matio_create
+ *   N      - size of the matrix (NxN)
+ *   r0, c0 - global position of the block
+ *   rows   - rows of the block, may be 0 for processes without a block
+ *   cols   - columns of the block
+ *   block  - the block, with ld elements between its rows
+ *
+ * Notes:
+ *   A block is `rows` pieces of `cols` elements, N apart in the file and ld
+ *   apart in memory. A vector datatype describes each side, the file one
+ *   becomes the file view so the MPI library can merge the pieces of all
+ *   processes into large writes.
+ */
+void matio_write_block(MPI_File fh, int N, MPI_Datatype type, int r0, int c0, int rows, int cols,
+                       const void *block, int ld) {
+    MPI_Offset disp = MATIO_HEADER_SIZE + ((MPI_Offset)r0 * N + c0) * type_size(type);
+
+    if (rows == 0 || cols == 0) {
+        // set_view and write_at_all are collective, take part without data
+        MPI_File_set_view(fh, MATIO_HEADER_SIZE, type, type, "native", MPI_INFO_NULL);
+        MPI_File_write_at_all(fh, 0, block, 0, type, MPI_STATUS_IGNORE);
+    } else {
+        MPI_Datatype file_type, mem_type;
+        MPI_Type_vector(rows, cols, N, type, &file_type);
+        MPI_Type_vector(rows, cols, ld, type, &mem_type);
+        MPI_Type_commit(&file_type);
+        MPI_Type_commit(&mem_type);
+
+        MPI_File_set_view(fh, disp, type, file_type, "native", MPI_INFO_NULL);
+        MPI_File_write_at_all(fh, 0, block, 1, mem_type, MPI_STATUS_IGNORE);
+
+        MPI_Type_free(&file_type);
+        MPI_Type_free(&mem_type);
+    }
+
+    // back to the default view of plain bytes
+    MPI_File_set_view(fh, 0, MPI_BYTE, MPI_BYTE, "native", MPI_INFO_NULL);
+}
+
+/**
+ * matio_open
+ * ----------
+ * Collectively opens a matrix file for reading and checks its header.
+ *
+ * Parameters:
+ *   path - file to open
+ *   type - element type the matrix has to have
+ *   fh   - set to the open file
+ *   N    - set to the size of the (square) matrix in the file
+ *
+ * Returns:
+ *   0 on success, 1 if the file cannot be opened or does not hold a square
+ *   row-major matrix of `type`. All processes return the same value, rank
+ *   0 prints the reason.
+ *
+ * Notes:
+ *   Every process reads the 32 byte header itself, which is cheaper than
+ *   having rank 0 read and broadcast it.
+ */
+int matio_open(const char *path, MPI_Datatype type, MPI_File *fh, int *N) {
+    int rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+    int err = MPI_File_open(MPI_COMM_WORLD, path, MPI_MODE_RDONLY, MPI_INFO_NULL, fh);
+    if (err != MPI_SUCCESS) {
+        if (rank == 0) {
+            char msg[MPI_MAX_ERROR_STRING];
+            int len;
+            MPI_Error_string(err, msg, &len);
+            fprintf(stderr, "Failed to open %s for reading: %s\n", path, msg);
+        }
+        return 1;
+    }
+
+    matio_header h;
+    MPI_Offset file_size;
+    memset(&h, 0, sizeof(h));
+    MPI_File_read_at_all(*fh, 0, &h, sizeof(h), MPI_BYTE, MPI_STATUS_IGNORE);
+    MPI_File_get_size(*fh, &file_size);
+
+    const char *problem = NULL;
+    char detail[96];
+    if (memcmp(h.magic, MATIO_MAGIC, sizeof(MATIO_MAGIC)) != 0) {
+        problem = "is not a matrix file";
+    } else if (h.layout != MATIO_ROW_MAJOR) {
+        problem = "does not hold a row-major matrix";
+    } else if (h.dtype != file_dtype(type)) {
+        snprintf(detail, sizeof(detail), "holds %s elements, this run needs %s (see --precision)",
+                 dtype_name(h.dtype), dtype_name(file_dtype(type)));
+        problem = detail;
+    } else if (h.rows != h.cols || h.rows <= 0 || h.rows > INT_MAX) {
+        problem = "does not hold a square matrix of a supported size";
+    } else if (file_size < MATIO_HEADER_SIZE + (MPI_Offset)h.rows * h.cols * type_size(type)) {
+        problem = "is shorter than its header says";
+    }
+    if (problem) {
+        if (rank == 0) fprintf(stderr, "%s %s\n", path, problem);
+        MPI_File_close(fh);
+        return 1;
+    }
+
+    *N = (int)h.rows;
+    return 0;
+}
+
+/**
+ * matio_read_block
+ * ----------------
+ * Collective: every process reads the rows x cols block of the matrix
+ * whose top left element is at global position (r0, c0).
+ *
+ * Notes:
+ *   The counterpart of matio_write_block, with the same datatypes. Whole
+ *   rows (c0 = 0, cols = N) make a single contiguous piece of the file.
+ */
+void matio_read_block(MPI_File fh, int N, MPI_Datatype type, int r0, int c0, int rows, int cols,
+                      void *block, int ld) {
+    MPI_Offset disp = MATIO_HEADER_SIZE + ((MPI_Offset)r0 * N + c0) * type_size(type);
+
+    if (rows == 0 || cols == 0) {
+        MPI_File_set_view(fh, MATIO_HEADER_SIZE, type, type, "native", MPI_INFO_NULL);
+        MPI_File_read_at_all(fh, 0, block, 0, type, MPI_STATUS_IGNORE);
+    } else {
+        MPI_Datatype file_type, mem_type;
+        MPI_Type_vector(rows, cols, N, type, &file_type);
+        MPI_Type_vector(rows, cols, ld, type, &mem_type);
+        MPI_Type_commit(&file_type);
+        MPI_Type_commit(&mem_type);
+
+        MPI_File_set_view(fh, disp, type, file_type, "native", MPI_INFO_NULL);
+        MPI_File_read_at_all(fh, 0, block, 1, mem_type, MPI_STATUS_IGNORE);
+
+        MPI_Type_free(&file_type);
+        MPI_Type_free(&mem_type);
+    }
+
+    MPI_File_set_view(fh, 0, MPI_BYTE, MPI_BYTE, "native", MPI_INFO_NULL);
+}
+
+/**
+ * matio_read_all
+ * --------------
+ * Reads the whole N x N matrix into mat. Not collective, meant for rank 0
+ * reading a small matrix for the text output.
+ */
+void matio_read_all(MPI_File fh, int N, MPI_Datatype type, void *mat) {
+    MPI_Datatype row_type;
+    MPI_Type_contiguous(N, type, &row_type);
+    MPI_Type_commit(&row_type);
+    MPI_File_read_at(fh, MATIO_HEADER_SIZE, mat, N, row_type, MPI_STATUS_IGNORE);
+    MPI_Type_free(&row_type);
+}
+
+/**
+ * matio_iread_rows / matio_iwrite_rows
+ * ------------------------------------
+ * Independent and nonblocking: starts reading (or writing) consecutive
+ * whole rows of the matrix, completed by waiting on *req. Not collective,
+ * every process may call them at its own pace.
+ *
+ * Parameters:
+ *   fh        - file from matio_open / matio_create, with its default view
+ *   N         - size of the matrix (NxN)
+ *   first_row - global index of the first row
+ *   rows      - number of rows, counted in a row datatype so rows * N may
+ *               exceed an int
+ *   data      - rows x N elements, not touched until the request completes
+ *
+ * Notes:
+ *   Freeing the datatype right away is allowed, the request keeps it
+ *   alive until it completes.
+ */
+void matio_iread_rows(MPI_File fh, int N, MPI_Datatype type, int first_row, int rows,
+                      void *data, MPI_Request *req) {
+    MPI_Offset offset = MATIO_HEADER_SIZE + (MPI_Offset)first_row * N * type_size(type);
+    MPI_Datatype row_type;
+    MPI_Type_contiguous(N, type, &row_type);
+    MPI_Type_commit(&row_type);
+    MPI_File_iread_at(fh, offset, data, rows, row_type, req);
+    MPI_Type_free(&row_type);
+}
+
+void matio_iwrite_rows(MPI_File fh, int N, MPI_Datatype type, int first_row, int rows,
+                       const void *data, MPI_Request *req) {
+    MPI_Offset offset = MATIO_HEADER_SIZE + (MPI_Offset)first_row * N * type_size(type);
+    MPI_Datatype row_type;
+    MPI_Type_contiguous(N, type, &row_type);
+    MPI_Type_commit(&row_type);
+    MPI_File_iwrite_at(fh, offset, data, rows, row_type, req);
+    MPI_Type_free(&row_type);
+}
+
+/**
+ * matio_close
+ * -----------
+ * Collectively closes a file from matio_create or matio_open.
+ */
+void matio_close(MPI_File *fh) {
+    MPI_File_close(fh);
+}
@@ -0,0 +1,65 @@
+/**
+ * Binary Matrix Files
+ * Matrices are stored as a 32 byte header followed by the elements in
+ * row-major order, all in the byte order of the machine that wrote them:
+ *
+ *   offset  size  field
+ *        0     8  magic "MATMUL1\0"
+ *        8     8  rows    (int64)
+ *       16     8  columns (int64)
+ *       24     4  element type, MATIO_FLOAT32/FLOAT64/BFLOAT16/FLOAT16
+ *       28     4  layout, MATIO_ROW_MAJOR
+ *
+ * The files are read and written with MPI-IO: every process reads or
+ * writes the part of the matrix it owns at its offset in the file with one
+ * collective call, so the matrix never has to pass through a single
+ * process. The out-of-core algorithm streams whole rows in and out with
+ * independent nonblocking calls instead.
+ */
+
+#ifndef MATIO_H
+#define MATIO_H
+
+#include <stdint.h>
+#include <mpi.h>
+#include "elem.h"
+
+#define MATIO_MAGIC "MATMUL1"
+#define MATIO_HEADER_SIZE 32
+
+// element types, the element formats of elem.h
+#define MATIO_FLOAT32  ELEM_FLOAT32
+#define MATIO_FLOAT64  ELEM_FLOAT64
+#define MATIO_BFLOAT16 ELEM_BFLOAT16
+#define MATIO_FLOAT16  ELEM_FLOAT16
+
+// layouts
+#define MATIO_ROW_MAJOR 0
+
+typedef struct {
+    char magic[8];
+    int64_t rows, cols;
+    int32_t dtype;
+    int32_t layout;
+} matio_header;
+
+/*
+ * Every function below takes the element type of the matrix as an MPI
+ * datatype, the one matio_type returns for the element type code.
+ */
+MPI_Datatype matio_type(int32_t dtype);
+int  matio_create(const char *path, int N, MPI_Datatype type, MPI_File *fh);
+void matio_write_rows(MPI_File fh, int N, MPI_Datatype type, int first_row, int rows, const void *data);
+void matio_write_block(MPI_File fh, int N, MPI_Datatype type, int r0, int c0, int rows, int cols,
+                       const void *block, int ld);
+int  matio_open(const char *path, MPI_Datatype type, MPI_File *fh, int *N);
+void matio_read_block(MPI_File fh, int N, MPI_Datatype type, int r0, int c0, int rows, int cols,
+                      void *block, int ld);
+void matio_read_all(MPI_File fh, int N, MPI_Datatype type, void *mat);
+void matio_iread_rows(MPI_File fh, int N, MPI_Datatype type, int first_row, int rows,
+                      void *data, MPI_Request *req);
+void matio_iwrite_rows(MPI_File fh, int N, MPI_Datatype type, int first_row, int rows,
+                       const void *data, MPI_Request *req);
+void matio_close(MPI_File *fh);
+
+#endif
@@ -5,12 +5,20 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <math.h>
 #include <time.h>
 #include <string.h> 
+#include <limits.h>
+#include <getopt.h>
 #include <mpi.h>
+#include "kernels.h"
+#include "algorithms.h"
+#include "rng.h"
+#include "results.h"
+#include "verify.h"
 
 #define MAX_CONSOLE_MATRIX_SIZE 16
-#define MAX_FILE_MATRIX_SIZE 256
+#define MAX_FILE_MATRIX_SIZE 2048
 #define OUTPUT_FILE "matrix_calculation.txt"
 
 /**
@@ -19,68 +27,196 @@
  * Fills an NxN matrix with random float values in [start, end).
  *
  * Parameters:
- *   mat   - pointer to the float array to fill
+ *   mat   - pointer to the array to fill
  *   N     - size of the matrix (NxN)
  *   start - inclusive lower bound of the range
  *   end   - exclusive upper bound of the range
+ *   format - element format of mat (see elem.h): the float values are
+ *            stored in it, exactly in double, rounded in bfloat16 and half
  *
  * Notes:
  *   Call srand() once before using this function to seed the RNG.
  */
-void generate_matrix(float *mat, int N, float start, float end) {
-    for (int i = 0; i < N * N; i++) {
+void generate_matrix(void *mat, int N, float start, float end, int format) {
+    size_t count = (size_t)N * N;  // N * N overflows an int beyond N = 46340
+    for (size_t i = 0; i < count; i++) {
         float r = (float)rand() / RAND_MAX;   // [0, 1)
-        mat[i] = start + r * (end - start);   // [start, end)
+        float v = start + r * (end - start);  // [start, end)
+        elem_store(mat, i, format, v);
     }
 }
 
+/**
+ * fill_philox
+ * -----------
+ * fill_fn that produces the parts of A and B with the counter-based
+ * generator, so each process only generates the elements it owns.
+ */
+static void fill_philox(const run_ctx *ctx, int matrix, int r0, int c0,
+                        int rows, int cols, void *dst, int ld) {
+    philox_fill_elems(ctx->seed, matrix, r0, c0, rows, cols, dst, ld, ctx->in_format);
+}
+
+/**
+ * write_thousandths
+ * -----------------
+ * Writes v / 1000 with 3 decimals to buf, with a '-' in front if negative
+ * is set. Shared by format_float and format_double.
+ *
+ * Returns:
+ *   Number of characters written.
+ */
+static int write_thousandths(long long v, int negative, char *buf) {
+    int len = 0;
+    if (negative) buf[len++] = '-';
+    unsigned long long u = v < 0 ? -(unsigned long long)v : (unsigned long long)v;
+
+    char digits[24];
+    int n = 0;
+    do {
+        digits[n++] = '0' + u % 10;
+        u /= 10;
+    } while (u > 0 || n < 4);   // at least one digit before the point
+
+    while (n > 3) buf[len++] = digits[--n];
+    buf[len++] = '.';
+    while (n > 0) buf[len++] = digits[--n];
+    return len;
+}
+
+/**
+ * format_float
+ * ------------
+ * Writes x with 3 decimals to buf, the same text as printf("%.3f", x).
+ *
+ * Parameters:
+ *   x   - value to format
+ *   buf - at least 64 bytes, not NUL-terminated
+ *
+ * Returns:
+ *   Number of characters written.
+ *
+ * Notes:
+ *   - A float has a 24-bit mantissa, so x * 1000 is exact in a double and
+ *     llrint rounds it to the nearest integer, ties to even, just like
+ *     printf. The digits are then written out by hand, which is many times
+ *     faster than a call to snprintf per element.
+ *   - Values too large for a long long, inf and nan go through snprintf.
+ */
+static int format_float(float x, char *buf) {
+    double scaled = (double)x * 1000.0;
+    if (!(fabs(scaled) < 1e18)) return snprintf(buf, 64, "%.3f", x);
+
+    long long v = llrint(scaled);
+    // printf keeps the sign of negative numbers that round to 0
+    return write_thousandths(v, v < 0 || signbit(x), buf);
+}
+
+/**
+ * format_double
+ * -------------
+ * format_float for a double, the same text as printf("%.3f", x).
+ *
+ * Notes:
+ *   x * 1000 is not exact in a double, it may be off by |x * 1000| * 2^-53.
+ *   Below 1e12 that is under 1e-3, so only values within 1e-3 of a rounding
+ *   tie can round the other way than printf. Those, and larger values, go
+ *   through snprintf.
+ */
+static int format_double(double x, char *buf) {
+    double scaled = x * 1000.0;
+    if (!(fabs(scaled) < 1e12) || fabs(scaled - floor(scaled) - 0.5) < 1e-3) {
+        return snprintf(buf, 64, "%.3f", x);
+    }
+
+    long long v = llrint(scaled);
+    return write_thousandths(v, v < 0 || signbit(x), buf);
+}
+
+/**
+ * format_element
+ * --------------
+ * Formats element i of an array of `format` elements (see elem.h).
+ *
+ * Notes:
+ *   bfloat16 and half values are exact floats, so they print like floats.
+ */
+static int format_element(const void *mat, size_t i, int format, char *buf) {
+    if (format == ELEM_FLOAT64) return format_double(((const double *)mat)[i], buf);
+    return format_float((float)elem_load(mat, i, format), buf);
+}
+
+/**
+ * fill_file
+ * ---------
+ * fill_fn that reads the parts of A and B from the input files, every
+ * process reading only the elements it owns with one collective read.
+ */
+static void fill_file(const run_ctx *ctx, int matrix, int r0, int c0,
+                      int rows, int cols, void *dst, int ld) {
+    matio_read_block(ctx->input[matrix], ctx->N, ctx->in_type, r0, c0, rows, cols, dst, ld);
+}
+
 /**
  * get_matrix_string
  * -----------------
  * Converts an NxN matrix into a formatted string with aligned columns.
  *
  * Parameters:
- *   title - label for the matrix (e.g., "Matrix A")
- *   mat   - pointer to the float array (row-major order)
- *   N     - size of the matrix (NxN)
+ *   title  - label for the matrix (e.g., "Matrix A")
+ *   mat    - pointer to the array (row-major order)
+ *   N      - size of the matrix (NxN)
+ *   format - element format of mat, see elem.h
  *
  * Returns:
  *   Pointer to a heap-allocated string containing the formatted matrix.
  *   The caller is responsible for freeing the returned string.
  *
  * Notes:
- *   - Finds the widest element to align all columns properly.
+ *   - Finds the widest element to align all columns properly, every element
+ *     then takes exactly that many characters plus a space, so the size of
+ *     the string is known before it is written.
+ *   - The string is written through a position pointer instead of strcat,
+ *     which would scan everything written so far on every call and make the
+ *     whole thing quadratic in the size of the output.
  *   - Adds the title and newline characters for readability.
  */
-char* get_matrix_string(const char *title, float *mat, int N) {
+char* get_matrix_string(const char *title, const void *mat, int N, int format) {
+    size_t count = (size_t)N * N;
     int max_width = 0;
     char buffer[64];
 
     // First pass: find widest element
-    for (int i = 0; i < N * N; i++) {
-        int len = snprintf(buffer, sizeof(buffer), "%.3f", mat[i]);
+    for (size_t i = 0; i < count; i++) {
+        int len = format_element(mat, i, format, buffer);
         if (len > max_width) max_width = len;
     }
 
-    // Estimate total size needed (rough estimate, may allocate extra)
-    int estimated_size = N * N * (max_width + 4) + 1024;
-    char *out = malloc(estimated_size);
+    size_t title_len = strlen(title);
+    size_t size = title_len + 2 + count * (max_width + 1) + N + 1;
+    char *out = malloc(size);
     if (!out) return NULL;
-    out[0] = '\0';
+    char *pos = out;
 
     // Add title
-    strcat(out, title);
-    strcat(out, ":\n");
+    memcpy(pos, title, title_len);
+    pos += title_len;
+    *pos++ = ':';
+    *pos++ = '\n';
 
-    // Second pass: append each element
+    // Second pass: append each element, right aligned
     for (int i = 0; i < N; i++) {
         for (int j = 0; j < N; j++) {
-            char line[64];
-            snprintf(line, sizeof(line), "%*.*f ", max_width, 3, mat[i * N + j]);
-            strcat(out, line);
+            int len = format_element(mat, (size_t)i * N + j, format, buffer);
+            memset(pos, ' ', max_width - len);
+            pos += max_width - len;
+            memcpy(pos, buffer, len);
+            pos += len;
+            *pos++ = ' ';
         }
-        strcat(out, "\n");
+        *pos++ = '\n';
     }
+    *pos = '\0';
 
     return out;
 }
@@ -91,22 +227,323 @@ char* get_matrix_string(const char *title, float *mat, int N) {
  * Prints an NxN matrix to stdout with nicely aligned columns.
  *
  * Parameters:
- *   title - label for the matrix (e.g., "Matrix A")
- *   mat   - pointer to the float array (row-major order)
- *   N     - size of the matrix (NxN)
+ *   title  - label for the matrix (e.g., "Matrix A")
+ *   mat    - pointer to the array (row-major order)
+ *   N      - size of the matrix (NxN)
+ *   format - element format of mat, see elem.h
  *
  * Notes:
  *   - Internally calls get_matrix_string to format the matrix.
  *   - Frees the temporary string after printing.
  */
-void print_matrix(const char *title, float *mat, int N) {
-    char *matrix_str = get_matrix_string(title, mat, N);
+void print_matrix(const char *title, const void *mat, int N, int format) {
+    char *matrix_str = get_matrix_string(title, mat, N, format);
     if (matrix_str) {
         printf("%s", matrix_str);
         free(matrix_str);
     }
 }
 
+/**
+ * options
+ * -------
+ * Settings taken from the command line, identical on every rank.
+ */
+typedef struct {
+    int N;                          // size of the matrices (NxN)
+    const kernel_info *kernel;      // local multiplication kernel
+    const precision_info *prec;     // element types of A, B and C
+    int threads;                    // threads per process for the local multiplication
+    const algorithm_info *algo;     // how the matrices are distributed
+    int replication;                // replication factor c of the 2.5d algorithm
+    int philox;                     // generate A and B in parallel with Philox instead of rand(),
+                                    // -1 until --generator or --root-light decides
+    unsigned long seed;             // seed of either generator
+    const char *output;             // binary file for C written with MPI-IO, or NULL
+    const char *input[2];           // binary files of A and B (MATRIX_A/B), or NULL
+    double peak;                    // peak GFLOP/s of one core, 0 if not known
+    int measure_peak;               // measure the peak with the kernel at startup
+    const char *results;            // file the run's record is appended to, or NULL
+    int warmup;                     // untimed runs of the multiplication before the timed ones
+    int repeat;                     // timed runs of the multiplication
+    int verify;                     // check C with Freivalds' test after the runs
+    double memory;                  // MiB of working set per process for the ooc algorithm
+    int root_light;                 // rank 0 never holds all of A, B or C
+} options;
+
+/**
+ * print_usage
+ * -----------
+ * Prints the command line syntax, the available algorithms and kernels to stderr.
+ */
+void print_usage(const char *prog) {
+    fprintf(stderr, "Usage: %s [options] <matrix_size>\n", prog);
+    fprintf(stderr, "       %s [options] --a FILE --b FILE [<matrix_size>]\n", prog);
+    fprintf(stderr, "Options:\n");
+    fprintf(stderr, "  -a, --algo NAME     distributed algorithm, one of:\n");
+    print_algorithms(stderr);
+    fprintf(stderr, "  -c, --replication C copies of A and B kept by the 2.5d algorithm, P must be\n"
+                    "                      C * q^2 with q >= C (default: 1, which is SUMMA)\n");
+    fprintf(stderr, "  -k, --kernel NAME   local multiplication kernel, one of:\n");
+    print_kernels(stderr);
+    fprintf(stderr, "  -P, --precision P   element types of the matrices, one of:\n");
+    print_precisions(stderr);
+    fprintf(stderr, "  -t, --threads T     threads per process for the local multiplication\n"
+                    "                      (default: OMP_NUM_THREADS, or 1 without OpenMP)\n");
+    fprintf(stderr, "  -g, --generator G   how A and B are generated (default: rand):\n"
+                    "                        rand    rand() on rank 0, then scattered\n"
+                    "                        philox  every process generates its own parts with a\n"
+                    "                                counter-based RNG, same matrices for any P\n");
+    fprintf(stderr, "  -s, --seed S        seed of the random matrices (default: 42)\n");
+    fprintf(stderr, "  -A, --a FILE        read A from a binary matrix file (see matio.h) instead of\n"
+                    "                      generating it, every process reads its own part\n");
+    fprintf(stderr, "  -B, --b FILE        read B from a binary matrix file, needs --a as well\n");
+    fprintf(stderr, "  -p, --peak GFLOPS   peak GFLOP/s of one core, for the percent of peak in the\n"
+                    "                      summary, or \"auto\" to time the kernel on one core\n");
+    fprintf(stderr, "  -o, --output FILE   every process writes its part of C to FILE with MPI-IO\n"
+                    "                      (binary, see matio.h) instead of gathering C on rank 0\n");
+    fprintf(stderr, "  -L, --root-light    rank 0 needs no more memory than the others: A and B are\n"
+                    "                      generated (philox) or read in parallel and C is never\n"
+                    "                      gathered, only written with --output or checked with --verify\n");
+    fprintf(stderr, "  -m, --memory MIB    working set per process of the ooc algorithm, in MiB\n"
+                    "                      (default: 1024)\n");
+    fprintf(stderr, "  -w, --warmup W      untimed runs of the multiplication first (default: 0)\n");
+    fprintf(stderr, "  -n, --repeat R      timed runs of the multiplication, the summary shows their\n"
+                    "                      median, mean, stddev and best (default: 1)\n");
+    fprintf(stderr, "  -v, --verify        check C with Freivalds' test, O(N^2) on the parts of A, B\n"
+                    "                      and C every process holds, exit status 2 if it fails\n");
+    fprintf(stderr, "  -r, --results FILE  append every parameter and metric of the run to FILE, as a\n"
+                    "                      CSV row if FILE ends in .csv, else as a JSON line\n");
+    fprintf(stderr, "  -h, --help          show this message\n");
+}
+
+/**
+ * parse_args
+ * ----------
+ * Fills an options struct from argc/argv.
+ *
+ * Parameters:
+ *   argc, argv - the arguments passed to main
+ *   opt        - struct to fill in
+ *   rank       - rank of the calling process, only rank 0 reports errors
+ *
+ * Returns:
+ *   0 on success, 1 if the program should exit (bad arguments or --help).
+ */
+int parse_args(int argc, char *argv[], options *opt, int rank) {
+    static const struct option long_options[] = {
+        { "algo",        required_argument, NULL, 'a' },
+        { "replication", required_argument, NULL, 'c' },
+        { "kernel",      required_argument, NULL, 'k' },
+        { "precision",   required_argument, NULL, 'P' },
+        { "threads",     required_argument, NULL, 't' },
+        { "generator",   required_argument, NULL, 'g' },
+        { "seed",        required_argument, NULL, 's' },
+        { "output",      required_argument, NULL, 'o' },
+        { "a",           required_argument, NULL, 'A' },
+        { "b",           required_argument, NULL, 'B' },
+        { "peak",        required_argument, NULL, 'p' },
+        { "results",     required_argument, NULL, 'r' },
+        { "warmup",      required_argument, NULL, 'w' },
+        { "repeat",      required_argument, NULL, 'n' },
+        { "verify",      no_argument,       NULL, 'v' },
+        { "memory",      required_argument, NULL, 'm' },
+        { "root-light",  no_argument,       NULL, 'L' },
+        { "help",        no_argument,       NULL, 'h' },
+        { NULL, 0, NULL, 0 }
+    };
+
+    opt->N = 0;
+    opt->kernel = default_kernel();
+    opt->prec = default_precision();
+    opt->threads = kernel_threads();
+    opt->algo = default_algorithm();
+    opt->replication = 1;
+    opt->philox = -1;
+    opt->seed = 42;
+    opt->output = NULL;
+    opt->peak = 0.0;
+    opt->measure_peak = 0;
+    opt->results = NULL;
+    opt->warmup = 0;
+    opt->repeat = 1;
+    opt->verify = 0;
+    opt->memory = 1024.0;
+    opt->root_light = 0;
+    opt->input[MATRIX_A] = opt->input[MATRIX_B] = NULL;
+
+    // only rank 0 should complain, otherwise every process prints the same error
+    opterr = (rank == 0);
+
+    int c;
+    while ((c = getopt_long(argc, argv, "a:c:k:P:t:g:s:o:A:B:p:r:w:n:vm:Lh", long_options, NULL)) != -1) {
+        switch (c) {
+        case 'a':
+            opt->algo = find_algorithm(optarg);
+            if (!opt->algo) {
+                if (rank == 0) fprintf(stderr, "Unknown algorithm: %s\n", optarg);
+                return 1;
+            }
+            break;
+        case 'c':
+            opt->replication = atoi(optarg);
+            if (opt->replication <= 0) {
+                if (rank == 0) fprintf(stderr, "Invalid replication factor: must be a positive integer.\n");
+                return 1;
+            }
+            break;
+        case 'k':
+            opt->kernel = find_kernel(optarg);
+            if (!opt->kernel) {
+                if (rank == 0) fprintf(stderr, "Unknown kernel: %s\n", optarg);
+                return 1;
+            }
+            if (!kernel_supported(opt->kernel)) {
+                if (rank == 0) fprintf(stderr, "Kernel %s is not supported on this CPU\n", optarg);
+                return 1;
+            }
+            break;
+        case 'P':
+            opt->prec = find_precision(optarg);
+            if (!opt->prec) {
+                if (rank == 0) fprintf(stderr, "Unknown precision: %s\n", optarg);
+                return 1;
+            }
+            break;
+        case 't':
+            opt->threads = atoi(optarg);
+            if (opt->threads <= 0) {
+                if (rank == 0) fprintf(stderr, "Invalid thread count: must be a positive integer.\n");
+                return 1;
+            }
+            if (set_kernel_threads(opt->threads) != 0) {
+                if (rank == 0) fprintf(stderr, "Multiple threads requested, but matmul was built without OpenMP.\n");
+                return 1;
+            }
+            break;
+        case 'g':
+            if (strcmp(optarg, "philox") == 0) {
+                opt->philox = 1;
+            } else if (strcmp(optarg, "rand") == 0) {
+                opt->philox = 0;
+            } else {
+                if (rank == 0) fprintf(stderr, "Unknown generator: %s\n", optarg);
+                return 1;
+            }
+            break;
+        case 's': {
+            char *end;
+            opt->seed = strtoul(optarg, &end, 10);
+            if (*optarg == '\0' || *end != '\0') {
+                if (rank == 0) fprintf(stderr, "Invalid seed: must be a non-negative integer.\n");
+                return 1;
+            }
+            break;
+        }
+        case 'p':
+            if (strcmp(optarg, "auto") == 0) {
+                opt->measure_peak = 1;
+            } else {
+                opt->peak = atof(optarg);
+                if (opt->peak <= 0.0) {
+                    if (rank == 0) fprintf(stderr, "Invalid peak: must be a positive number or auto.\n");
+                    return 1;
+                }
+            }
+            break;
+        case 'r':
+            opt->results = optarg;
+            break;
+        case 'w':
+            opt->warmup = atoi(optarg);
+            if (opt->warmup < 0 || (opt->warmup == 0 && strcmp(optarg, "0") != 0)) {
+                if (rank == 0) fprintf(stderr, "Invalid warmup count: must be a non-negative integer.\n");
+                return 1;
+            }
+            break;
+        case 'n':
+            opt->repeat = atoi(optarg);
+            if (opt->repeat <= 0) {
+                if (rank == 0) fprintf(stderr, "Invalid repeat count: must be a positive integer.\n");
+                return 1;
+            }
+            break;
+        case 'v':
+            opt->verify = 1;
+            break;
+        case 'L':
+            opt->root_light = 1;
+            break;
+        case 'm':
+            opt->memory = atof(optarg);
+            if (opt->memory <= 0.0) {
+                if (rank == 0) fprintf(stderr, "Invalid memory size: must be a positive number of MiB.\n");
+                return 1;
+            }
+            break;
+        case 'o':
+            opt->output = optarg;
+            break;
+        case 'A':
+            opt->input[MATRIX_A] = optarg;
+            break;
+        case 'B':
+            opt->input[MATRIX_B] = optarg;
+            break;
+        case 'h':
+        default:
+            if (rank == 0) print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    // --verify reads A, B and C from memory, the ooc algorithm keeps them in files
+    if (opt->verify && !opt->algo->tile) {
+        if (rank == 0) fprintf(stderr, "--verify is not available with the %s algorithm.\n", opt->algo->name);
+        return 1;
+    }
+
+    // A and B come from files together or not at all
+    int from_files = (opt->input[MATRIX_A] != NULL);
+    if (from_files != (opt->input[MATRIX_B] != NULL)) {
+        if (rank == 0) fprintf(stderr, "--a and --b have to be given together.\n");
+        return 1;
+    }
+    if (from_files && opt->philox == 1) {
+        if (rank == 0) fprintf(stderr, "--generator cannot be combined with --a and --b.\n");
+        return 1;
+    }
+
+    // rand() runs on rank 0 only, root-light generates with philox instead
+    if (opt->root_light && opt->philox == 0) {
+        if (rank == 0) fprintf(stderr, "--generator rand generates A and B on rank 0, use philox with --root-light.\n");
+        return 1;
+    }
+    if (opt->philox == -1) opt->philox = opt->root_light && !from_files;
+
+    // the matrix size is optional with input files, it is in their headers
+    if (from_files && optind >= argc) return 0;
+
+    // check for valid arguments
+    if (optind >= argc) {
+        if (rank == 0) print_usage(argv[0]);
+        return 1;
+    }
+
+    // strtol returns 0 if the input is not a valid integer
+    // this is fine for the case where 0 is actually inputed since we don't want a 0x0 matrix,
+    // sizes beyond INT_MAX are rejected rather than wrapped around
+    char *end;
+    long n = strtol(argv[optind], &end, 10);
+    opt->N = (*end == '\0' && n > 0 && n <= INT_MAX) ? (int)n : 0;
+    if (opt->N <= 0) {
+        if (rank == 0) fprintf(stderr, "Invalid matrix size: must be a positive integer.\n");
+        return 1;
+    }
+
+    return 0;
+}
+
 /**
  * main
  * ----
@@ -114,162 +551,313 @@ void print_matrix(const char *title, float *mat, int N) {
  *
  * Responsibilities:
  *   - Initialize MPI environment.
- *   - Parse command-line arguments for matrix size.
- *   - Allocate memory for matrices (A, B, C) and local chunks.
- *   - Generate random matrices on rank 0.
- *   - Broadcast matrix B to all processes.
- *   - Scatter matrix A across processes.
- *   - Perform local matrix multiplication.
- *   - Gather local C chunks to rank 0.
+ *   - Parse command-line arguments for matrix size, algorithm, kernel, precision and threads.
+ *   - Let the algorithm allocate its local chunks (and B where it needs it).
+ *   - Allocate the full matrices (A, B, C) on rank 0.
+ *   - Generate random matrices on rank 0, or with --generator philox let every
+ *     process generate its own parts of A and B, or with --a/--b let every
+ *     process read its own parts from the input files.
+ *   - Run the algorithm: distribute A and B, multiply locally, collect C on rank 0.
+ *     With --warmup/--repeat the run is repeated and the median time reported.
+ *   - With --output, let every process write its part of C to a binary file.
  *   - Print matrices to console if N <= MAX_CONSOLE_MATRIX_SIZE.
  *   - Write matrices and execution info to OUTPUT_FILE.
+ *   - Print the time per phase (min/mean/max over the processes).
+ *   - With --results, append a machine-readable record of the run.
  *   - Free allocated memory.
  *   - Finalize MPI.
  *
  * Usage:
- *   mpirun -np <num_processes> ./matrix_mpi <matrix_size>
+ *   mpirun -np <num_processes> ./matmul [options] <matrix_size>
+ *   mpirun -np <num_processes> ./matmul [options] --a A.bin --b B.bin
  *
  * Returns:
  *   0 on success, non-zero on error (e.g., invalid arguments or memory allocation failure).
  */
 int main(int argc, char* argv[]) {
-    // srand(time(NULL)); // set the seed randomly every time the program is run
-    srand(42); // fixed seed
-
     int rank, size, N;
 
-    // Every MPI program requires you to initialize MPI through MPI_Init first
-    MPI_Init(&argc, &argv);
+    // Every MPI program requires you to initialize MPI through MPI_Init first.
+    // The kernels may run OpenMP threads, but only the main thread calls MPI,
+    // which is what MPI_THREAD_FUNNELED promises the library.
+    int provided;
+    MPI_Init_thread(&argc, &argv, MPI_THREAD_FUNNELED, &provided);
     // The default communicator is comm world, this represents all of our processes
     // we can figure out the rank of our current process within the communicator, in a world using MPI_Comm_rank
     MPI_Comm_rank(MPI_COMM_WORLD, &rank);
     // Similarly, we can get the total number of processes in our communicator
     MPI_Comm_size(MPI_COMM_WORLD, &size);
 
-    // check for valid arguments
-    if (argc < 2) {
-        if (rank == 0) fprintf(stderr, "Usage: %s <matrix_size>\n", argv[0]);
+    options opt;
+    if (parse_args(argc, argv, &opt, rank) != 0) {
         // Always finalize mpi before exiting the program
         MPI_Finalize();
         return 1;
     }
 
-    // atoi returns 0 if the input is not a valid integer
-    // this is fine for the case where 0 is actually inputed since we don't want a 0x0 matrix
-    N = atoi(argv[1]);
-    if (N <= 0) {
-        if (rank == 0) fprintf(stderr, "Invalid matrix size: must be a positive integer.\n");
+    // A and B travel as in_type, C as out_type, the MPI types of their element formats
+    const precision_info *prec = opt.prec;
+    MPI_Datatype in_type = matio_type(prec->in_format);
+    MPI_Datatype out_type = matio_type(prec->out_format);
+
+    // with input files the size comes from their headers, which have to agree
+    // with each other and with the size on the command line, if one was given
+    MPI_File input[2] = { MPI_FILE_NULL, MPI_FILE_NULL };
+    int from_files = (opt.input[MATRIX_A] != NULL);
+    if (from_files) {
+        int n_a, n_b;
+        if (matio_open(opt.input[MATRIX_A], in_type, &input[MATRIX_A], &n_a) != 0) {
+            MPI_Finalize();
+            return 1;
+        }
+        if (matio_open(opt.input[MATRIX_B], in_type, &input[MATRIX_B], &n_b) != 0) {
+            matio_close(&input[MATRIX_A]);
+            MPI_Finalize();
+            return 1;
+        }
+        if (n_a != n_b || (opt.N != 0 && opt.N != n_a)) {
+            if (rank == 0) {
+                fprintf(stderr, "Matrix sizes do not match: A is %dx%d, B is %dx%d", n_a, n_a, n_b, n_b);
+                if (opt.N != 0) fprintf(stderr, ", requested %dx%d", opt.N, opt.N);
+                fprintf(stderr, "\n");
+            }
+            matio_close(&input[MATRIX_A]);
+            matio_close(&input[MATRIX_B]);
+            MPI_Finalize();
+            return 1;
+        }
+        opt.N = n_a;
+    }
+    N = opt.N;
+
+    // srand(time(NULL)); // set the seed randomly every time the program is run
+    srand(opt.seed); // fixed seed, 42 unless --seed is given
+
+    run_ctx ctx = { 0 };
+    ctx.N = N;
+    ctx.rank = rank;
+    ctx.size = size;
+    ctx.kernel = opt.kernel;
+    ctx.precision = prec->id;
+    ctx.in_format = prec->in_format;
+    ctx.out_format = prec->out_format;
+    ctx.in_size = prec->in_size;
+    ctx.out_size = prec->out_size;
+    ctx.in_type = in_type;
+    ctx.out_type = out_type;
+    ctx.replication = opt.replication;
+    ctx.distributed_input = opt.philox || from_files;
+    ctx.fill = from_files ? fill_file : fill_philox;
+    ctx.seed = opt.seed;
+    ctx.input[MATRIX_A] = input[MATRIX_A];
+    ctx.input[MATRIX_B] = input[MATRIX_B];
+    ctx.distributed_output = (opt.output != NULL) || opt.root_light;
+    ctx.output_file = (opt.output != NULL);
+    ctx.memory = (size_t)(opt.memory * (1 << 20));
+
+    // the algorithm allocates its local chunks, and B if every process needs all of it
+    if (opt.algo->setup(&ctx) != 0) {
+        if (from_files) {
+            matio_close(&input[MATRIX_A]);
+            matio_close(&input[MATRIX_B]);
+        }
         MPI_Finalize();
         return 1;
     }
-    // we must be able to give equal sized chunks to each processor
-    if (N % size != 0) {
-        if (rank == 0) fprintf(stderr, "Invalid matrix size: must be divisible by number of processes.\n");
+    int main_owns_B = (ctx.B == NULL);
+
+    // open the output file before any work is done, so a bad path fails early
+    MPI_File out_file = MPI_FILE_NULL;
+    if (ctx.output_file && matio_create(opt.output, N, out_type, &out_file) != 0) {
+        opt.algo->cleanup(&ctx);
+        if (from_files) {
+            matio_close(&input[MATRIX_A]);
+            matio_close(&input[MATRIX_B]);
+        }
         MPI_Finalize();
         return 1;
     }
+    ctx.output = out_file;
 
-    // how many rows of the matrix each process handles
-    int rows_per_process = N / size;
-
-    // Each process contains the entire, B, and a chunk of A, and C
-    float *A = NULL, *B = NULL, *C = NULL;
-    float *local_A = malloc(rows_per_process * N * sizeof(float));
-    float *local_C = malloc(rows_per_process * N * sizeof(float));
-    B = malloc(N * N * sizeof(float));
-
-    if (!B || !local_A || !local_C) {
-        fprintf(stderr, "Memory allocation failed\n");
-        MPI_Abort(MPI_COMM_WORLD, 1);
+    // every process times the kernel on its core, the fastest one counts as the peak
+    if (opt.measure_peak) {
+        double measured = measure_kernel_gflops(opt.kernel, prec);
+        MPI_Allreduce(&measured, &opt.peak, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
     }
 
-    if (rank == 0) {
-        A = malloc(N * N * sizeof(float));
-        // initialize C to all zeros
-        C = calloc(N * N, sizeof(float));
-        if (!A || !C) {
+    double t = MPI_Wtime();
+    if (ctx.distributed_input) {
+        // every process generates or reads its own parts of A and B, rank 0 only needs C
+        opt.algo->load(&ctx);
+        phase_lap(ctx.times, from_files ? PHASE_FILE_IO : PHASE_GENERATE, &t);
+        if (rank == 0 && !ctx.distributed_output) {
+            ctx.C = calloc((size_t)N * N, ctx.out_size);
+            if (!ctx.C) {
+                fprintf(stderr, "Memory allocation failed\n");
+                MPI_Abort(MPI_COMM_WORLD, 1);
+            }
+        }
+    } else if (rank == 0) {
+        ctx.A = malloc((size_t)N * N * ctx.in_size);
+        // initialize C to all zeros, with distributed output it is never collected
+        if (!ctx.distributed_output) ctx.C = calloc((size_t)N * N, ctx.out_size);
+        if (main_owns_B) ctx.B = malloc((size_t)N * N * ctx.in_size);
+        if (!ctx.A || !ctx.B || (!ctx.C && !ctx.distributed_output)) {
             fprintf(stderr, "Memory allocation failed\n");
             MPI_Abort(MPI_COMM_WORLD, 1);
         }
         
         // C is already set to 0's, randomly generate the A, B matrices
-        generate_matrix(A, N, -100, 101);
-        generate_matrix(B, N, -100, 101);
+        generate_matrix(ctx.A, N, MATRIX_MIN, MATRIX_MAX, ctx.in_format);
+        generate_matrix(ctx.B, N, MATRIX_MIN, MATRIX_MAX, ctx.in_format);
+        phase_lap(ctx.times, PHASE_GENERATE, &t);
     }
 
     MPI_Barrier(MPI_COMM_WORLD); // ensure all processes start together
 
     if (rank == 0) {
-        printf("Starting matrix multiplication with %d processes...\n", size);
+        printf("Starting matrix multiplication with %d processes and %d threads per process...\n",
+               size, opt.threads);
     }
-    // begin timer
-    double start = MPI_Wtime();
-
-    // int MPI_Bcast(
-    //     void *buffer,           starting address of buffer to broadcast
-    //     int count,              number of elements in buffer
-    //     MPI_Datatype datatype,  type of each element
-    //     int root,               rank of broadcasting process
-    //     MPI_Comm comm,          communicator
-    // );
-
-    // this gives each process the entire B matrix
-    MPI_Bcast(B, N * N, MPI_FLOAT, 0, MPI_COMM_WORLD);
-
-    // int MPI_Scatter(
-    //     const void *sendbuf,    starting address of send buffer (root only)
-    //     int sendcount,          number of elements sent to each process
-    //     MPI_Datatype sendtype,  type of each send element
-    //     void *recvbuf,          starting address of receive buffer
-    //     int recvcount,          number of elements received by each process
-    //     MPI_Datatype recvtype,  type of each receive element
-    //     int root,               rank of sending process
-    //     MPI_Comm comm,          communicator
-    // );
-
-    // Spreads out A across all processes
-    MPI_Scatter(A, rows_per_process * N, MPI_FLOAT,
-                local_A, rows_per_process * N, MPI_FLOAT, 0, MPI_COMM_WORLD);
-
-    // Note we do not need to send C anywhere, since we initialized it to 0's
-
-    // Local matrix multiplication
-    for (int i = 0; i < rows_per_process; i++) {
-        for (int k = 0; k < N; k++) {
-            for (int j = 0; j < N; j++) {
-                local_C[i * N + j] += local_A[i * N + k] * B[k * N + j];
-            }
-        }
+
+    // warmup runs fault in the pages of every buffer and warm the caches,
+    // their phase times are thrown away
+    double before_times[NUM_PHASES], before_bytes[NUM_PHASES];
+    memcpy(before_times, ctx.times, sizeof(before_times));
+    memcpy(before_bytes, ctx.bytes, sizeof(before_bytes));
+    for (int w = 0; w < opt.warmup; w++) {
+        opt.algo->run(&ctx);
+        MPI_Barrier(MPI_COMM_WORLD);
     }
+    memcpy(ctx.times, before_times, sizeof(before_times));
+    memcpy(ctx.bytes, before_bytes, sizeof(before_bytes));
 
-    // int MPI_Gather(
-    //     const void *sendbuf,    starting address of local data to send
-    //     int sendcount,          number of elements sent by each process
-    //     MPI_Datatype sendtype,  type of each element sent
-    //     void *recvbuf,          starting address of buffer to receive gathered data (root only)
-    //     int recvcount,          number of elements received from each process
-    //     MPI_Datatype recvtype,  type of each received element
-    //     int root,               rank of receiving process
-    //     MPI_Comm comm,          communicator
-    // );
-
-    // Gather the local C buffers to compile the entire C result matrix in one process
-    MPI_Gather(local_C, rows_per_process * N, MPI_FLOAT,
-               C, rows_per_process * N, MPI_FLOAT, 0, MPI_COMM_WORLD);
-
-    MPI_Barrier(MPI_COMM_WORLD); // ensure all processes end together
-    double end = MPI_Wtime();   
+    double *samples = malloc(opt.repeat * sizeof(double));
+    if (!samples) {
+        fprintf(stderr, "Memory allocation failed\n");
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+    for (int r = 0; r < opt.repeat; r++) {
+        MPI_Barrier(MPI_COMM_WORLD); // ensure all processes start together
+        // begin timer
+        double start = MPI_Wtime();
+
+        opt.algo->run(&ctx);
+
+        MPI_Barrier(MPI_COMM_WORLD); // ensure all processes end together
+        samples[r] = MPI_Wtime() - start;
+    }
     if (rank == 0) {
         printf("Finished Multiplication.\n");
     }
 
+    // the phase table shows one run: the mean of the timed runs
+    for (int p = 0; p < NUM_PHASES; p++) {
+        ctx.times[p] = before_times[p] + (ctx.times[p] - before_times[p]) / opt.repeat;
+        ctx.bytes[p] = before_bytes[p] + (ctx.bytes[p] - before_bytes[p]) / opt.repeat;
+    }
+    sample_stats exec_time;
+    compute_sample_stats(samples, opt.repeat, &exec_time);
+    free(samples);
+
+    // every process writes its own part of C, timed separately from the multiplication
+    double write_time = 0.0;
+    if (ctx.output_file) {
+        double write_start = MPI_Wtime();
+        opt.algo->store(&ctx, out_file);
+        matio_close(&out_file);
+        write_time = MPI_Wtime() - write_start;
+        ctx.times[PHASE_FILE_IO] += write_time;
+    }
+
+    // Freivalds' test on the parts of A, B and C the processes still hold
+    verify_result check;
+    if (opt.verify) {
+        t = MPI_Wtime();
+        verify_product(opt.algo, &ctx, &check);
+        phase_lap(ctx.times, PHASE_VERIFY, &t);
+    }
+
+    // where A and B came from
+    char input_desc[256];
+    if (from_files) {
+        snprintf(input_desc, sizeof(input_desc), "%s, %s", opt.input[MATRIX_A], opt.input[MATRIX_B]);
+    } else {
+        snprintf(input_desc, sizeof(input_desc), "%s (seed %lu)", opt.philox ? "philox" : "rand", opt.seed);
+    }
+
+    // 2N^3 flops: N^2 elements of C, each N multiplies and N adds
+    double gflops = 2.0 * N * N * N / exec_time.median / 1e9;
+
     if (rank == 0) {
-        printf("Execution Time: %f seconds\nMatrix Size: %dx%d\nNumber of Processes: %d\n\n", end - start, N, N, size);
+        char perf_desc[512];
+        int len = 0;
+        if (opt.repeat > 1 || opt.warmup > 0) {
+            // with repeats the execution time is the median
+            len += snprintf(perf_desc + len, sizeof(perf_desc) - len,
+                            "Repeats: %d timed after %d warmup\n"
+                            "Time (s): median %f, mean %f, stddev %f, best %f\n",
+                            opt.repeat, opt.warmup, exec_time.median, exec_time.mean,
+                            exec_time.stddev, exec_time.best);
+        }
+        len += snprintf(perf_desc + len, sizeof(perf_desc) - len,
+                        "Performance: %.3f GFLOP/s (%.3f GFLOP/s per process)",
+                        gflops, gflops / size);
+        if (opt.repeat > 1) {
+            len += snprintf(perf_desc + len, sizeof(perf_desc) - len, ", best %.3f GFLOP/s",
+                            2.0 * N * N * N / exec_time.best / 1e9);
+        }
+        len += snprintf(perf_desc + len, sizeof(perf_desc) - len, "\n");
+        if (opt.peak > 0.0) {
+            double total_peak = opt.peak * size * opt.threads;
+            len += snprintf(perf_desc + len, sizeof(perf_desc) - len,
+                            "Peak: %.3f GFLOP/s per core%s, %.1f%% of %.3f GFLOP/s\n",
+                            opt.peak, opt.measure_peak ? " (measured)" : "", 100.0 * gflops / total_peak, total_peak);
+        }
+        if (opt.verify) {
+            len += snprintf(perf_desc + len, sizeof(perf_desc) - len,
+                            "Verification: %s (residual %.3e, tolerance %.3e)\n",
+                            check.passed ? "passed" : "FAILED", check.residual, check.tolerance);
+            if (!isnan(check.ref_error)) {
+                snprintf(perf_desc + len, sizeof(perf_desc) - len,
+                         "Error against fp32: %.3e (the same residual with the fp32 A and B)\n",
+                         check.ref_error);
+            }
+        }
 
-        if (N <= MAX_FILE_MATRIX_SIZE) {
-            char *A_str = get_matrix_string("Matrix A", A, N);
-            char *B_str = get_matrix_string("Matrix B", B, N);
-            char *C_str = get_matrix_string("Matrix C", C, N);
+        printf("Execution Time: %f seconds\nMatrix Size: %dx%d\nNumber of Processes: %d\n"
+               "Threads per Process: %d\nAlgorithm: %s\nKernel: %s\nPrecision: %s\nInput: %s\n%s\n",
+               exec_time.median, N, N, size, opt.threads, opt.algo->name, opt.kernel->name, prec->name,
+               input_desc, perf_desc);
+        if (ctx.output_file) {
+            printf("Output: %s (written in %f seconds)\n\n", opt.output, write_time);
+        }
+
+        // the text dump needs C on rank 0, which distributed output never collects
+        if (N <= MAX_FILE_MATRIX_SIZE && ctx.C) {
+            t = MPI_Wtime();
+
+            // with distributed input rank 0 never saw A (or B), generate or
+            // read the full matrices here just for the output, they are small
+            if (!ctx.A) {
+                ctx.A = malloc((size_t)N * N * ctx.in_size);
+                if (main_owns_B) ctx.B = malloc((size_t)N * N * ctx.in_size);
+                if (!ctx.A || !ctx.B) {
+                    fprintf(stderr, "Memory allocation failed\n");
+                    MPI_Abort(MPI_COMM_WORLD, 1);
+                }
+                if (from_files) {
+                    matio_read_all(input[MATRIX_A], N, in_type, ctx.A);
+                    matio_read_all(input[MATRIX_B], N, in_type, ctx.B);
+                } else {
+                    philox_fill_elems(opt.seed, MATRIX_A, 0, 0, N, N, ctx.A, N, ctx.in_format);
+                    philox_fill_elems(opt.seed, MATRIX_B, 0, 0, N, N, ctx.B, N, ctx.in_format);
+                }
+            }
+
+            char *A_str = get_matrix_string("Matrix A", ctx.A, N, ctx.in_format);
+            char *B_str = get_matrix_string("Matrix B", ctx.B, N, ctx.in_format);
+            char *C_str = get_matrix_string("Matrix C", ctx.C, N, ctx.out_format);
 
             // Print to the console if the matrix is small enough
             if (N <= MAX_CONSOLE_MATRIX_SIZE) {
@@ -278,7 +866,10 @@ int main(int argc, char* argv[]) {
 
             FILE *f = fopen(OUTPUT_FILE, "w");
             if (f) {
-                fprintf(f, "Execution Time: %f seconds\nMatrix Size: %dx%d\nNumber of Processes: %d\n\n", end - start, N, N, size);
+                fprintf(f, "Execution Time: %f seconds\nMatrix Size: %dx%d\nNumber of Processes: %d\n"
+                        "Threads per Process: %d\nAlgorithm: %s\nKernel: %s\nPrecision: %s\nInput: %s\n%s\n",
+                        exec_time.median, N, N, size, opt.threads, opt.algo->name, opt.kernel->name, prec->name,
+                        input_desc, perf_desc);
                 fprintf(f, "%s\n%s\n%s\n", A_str, B_str, C_str);
                 fclose(f);
             } else {
@@ -288,18 +879,51 @@ int main(int argc, char* argv[]) {
             free(A_str); 
             free(B_str); 
             free(C_str);
+            phase_lap(ctx.times, PHASE_FORMAT, &t);
         }
 
         // free the large matrices only allocated on rank 0
-        free(A); 
-        free(C);
+        free(ctx.A); 
+        free(ctx.C);
+        if (main_owns_B) free(ctx.B);
     }
 
-    // All ranks have the entire B matrix and local parts of A and C
-    free(B); free(local_A); free(local_C);
+    // where the time went, over all processes
+    phase_summary phases;
+    reduce_phases(ctx.times, ctx.bytes, &phases);
+    char *hosts = opt.results ? gather_hosts() : NULL;
+
+    if (rank == 0) {
+        print_phase_report(&phases, stdout);
+
+        if (opt.results) {
+            run_result result = {
+                .N = N, .processes = size, .threads = opt.threads,
+                .algorithm = opt.algo->name, .kernel = opt.kernel->name,
+                .precision = prec->name,
+                .replication = opt.replication, .input = input_desc,
+                .warmup = opt.warmup, .repeat = opt.repeat,
+                .seconds = &exec_time, .gflops = gflops, .peak = opt.peak,
+                .verify = opt.verify ? &check : NULL,
+                .phases = &phases, .hosts = hosts,
+            };
+            append_results(opt.results, &result);
+            free(hosts);
+        }
+    }
+
+    // the algorithm frees its local chunks, and B if it allocated it
+    opt.algo->cleanup(&ctx);
+
+    // collective, so only after rank 0 is done reading for the text output
+    if (from_files) {
+        matio_close(&input[MATRIX_A]);
+        matio_close(&input[MATRIX_B]);
+    }
 
     // All MPI programs end with finalizing the MPI environment
     MPI_Finalize();
 
-    return 0;
+    // a failed check is an error for scripts and batch jobs
+    return (opt.verify && !check.passed) ? 2 : 0;
 }
\ No newline at end of file
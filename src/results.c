@@ -0,0 +1,251 @@
+/**
+ * Machine-Readable Results
+ * See results.h.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <mpi.h>
+#include "results.h"
+
+/**
+ * gather_hosts
+ * ------------
+ * Collective: collects the processor names of all processes on rank 0.
+ *
+ * Returns:
+ *   On rank 0 a heap-allocated, comma separated list of the distinct
+ *   names in rank order, NULL on the other ranks. The caller frees it.
+ */
+char *gather_hosts(void) {
+    int rank, size, len;
+    char name[MPI_MAX_PROCESSOR_NAME];
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+    memset(name, 0, sizeof(name));
+    MPI_Get_processor_name(name, &len);
+
+    char *all = NULL;
+    if (rank == 0) {
+        all = malloc((size_t)size * MPI_MAX_PROCESSOR_NAME);
+        if (!all) {
+            fprintf(stderr, "Memory allocation failed\n");
+            MPI_Abort(MPI_COMM_WORLD, 1);
+        }
+    }
+    MPI_Gather(name, MPI_MAX_PROCESSOR_NAME, MPI_CHAR,
+               all, MPI_MAX_PROCESSOR_NAME, MPI_CHAR, 0, MPI_COMM_WORLD);
+    if (rank != 0) return NULL;
+
+    char *list = malloc((size_t)size * (MPI_MAX_PROCESSOR_NAME + 1) + 1);
+    if (!list) {
+        fprintf(stderr, "Memory allocation failed\n");
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+    char *pos = list;
+    *pos = '\0';
+    for (int r = 0; r < size; r++) {
+        const char *host = all + (size_t)r * MPI_MAX_PROCESSOR_NAME;
+        int seen = 0;
+        for (int q = 0; q < r && !seen; q++) {
+            seen = strcmp(host, all + (size_t)q * MPI_MAX_PROCESSOR_NAME) == 0;
+        }
+        if (seen) continue;
+        if (pos != list) *pos++ = ',';
+        size_t n = strlen(host);
+        memcpy(pos, host, n + 1);
+        pos += n;
+    }
+    free(all);
+    return list;
+}
+
+/**
+ * write_json_string
+ * -----------------
+ * Writes s as a quoted JSON string, escaping quotes, backslashes and
+ * control characters.
+ */
+static void write_json_string(FILE *f, const char *s) {
+    fputc('"', f);
+    for (; *s; s++) {
+        unsigned char c = (unsigned char)*s;
+        if (c == '"' || c == '\\') {
+            fprintf(f, "\\%c", c);
+        } else if (c < 0x20) {
+            fprintf(f, "\\u%04x", c);
+        } else {
+            fputc(c, f);
+        }
+    }
+    fputc('"', f);
+}
+
+/**
+ * write_csv_string
+ * ----------------
+ * Writes s as a quoted CSV field, doubling any quotes in it.
+ */
+static void write_csv_string(FILE *f, const char *s) {
+    fputc('"', f);
+    for (; *s; s++) {
+        if (*s == '"') fputc('"', f);
+        fputc(*s, f);
+    }
+    fputc('"', f);
+}
+
+/**
+ * write_json
+ * ----------
+ * Writes one run as a single line JSON object. Every phase is an object
+ * with min/mean/max seconds and the bytes received.
+ */
+static void write_json(FILE *f, const char *timestamp, const run_result *r) {
+    fprintf(f, "{\"timestamp\": \"%s\", \"N\": %d, \"processes\": %d, \"threads\": %d, ",
+            timestamp, r->N, r->processes, r->threads);
+    fprintf(f, "\"algorithm\": ");
+    write_json_string(f, r->algorithm);
+    fprintf(f, ", \"kernel\": ");
+    write_json_string(f, r->kernel);
+    fprintf(f, ", \"precision\": ");
+    write_json_string(f, r->precision);
+    fprintf(f, ", \"replication\": %d, \"input\": ", r->replication);
+    write_json_string(f, r->input);
+    fprintf(f, ", \"warmup\": %d, \"repeat\": %d", r->warmup, r->repeat);
+    fprintf(f, ", \"seconds\": %.9g, \"seconds_mean\": %.9g, \"seconds_stddev\": %.9g, \"seconds_best\": %.9g",
+            r->seconds->median, r->seconds->mean, r->seconds->stddev, r->seconds->best);
+    fprintf(f, ", \"gflops\": %.9g, \"gflops_per_process\": %.9g",
+            r->gflops, r->gflops / r->processes);
+    if (r->peak > 0.0) {
+        double total_peak = r->peak * r->processes * r->threads;
+        fprintf(f, ", \"peak_per_core\": %.9g, \"percent_of_peak\": %.9g",
+                r->peak, 100.0 * r->gflops / total_peak);
+    } else {
+        fprintf(f, ", \"peak_per_core\": null, \"percent_of_peak\": null");
+    }
+    if (r->verify) {
+        // JSON has no NaN or infinity, a residual that is not finite is null
+        fprintf(f, ", \"verified\": %s, \"verify_residual\": ", r->verify->passed ? "true" : "false");
+        if (isfinite(r->verify->residual)) {
+            fprintf(f, "%.9g", r->verify->residual);
+        } else {
+            fprintf(f, "null");
+        }
+        fprintf(f, ", \"fp32_error\": ");
+        if (isfinite(r->verify->ref_error)) {
+            fprintf(f, "%.9g", r->verify->ref_error);
+        } else {
+            fprintf(f, "null");
+        }
+    } else {
+        fprintf(f, ", \"verified\": null, \"verify_residual\": null, \"fp32_error\": null");
+    }
+
+    fprintf(f, ", \"phases\": {");
+    for (int p = 0; p < NUM_PHASES; p++) {
+        fprintf(f, "%s\"%s\": {\"min\": %.9g, \"mean\": %.9g, \"max\": %.9g, \"bytes\": %.17g}",
+                p ? ", " : "", phase_key(p), r->phases->min[p], r->phases->mean[p],
+                r->phases->max[p], r->phases->bytes[p]);
+    }
+    fprintf(f, "}, \"hosts\": [");
+
+    // the comma separated list becomes a JSON array
+    const char *h = r->hosts;
+    while (*h) {
+        size_t n = strcspn(h, ",");
+        char host[MPI_MAX_PROCESSOR_NAME + 1];
+        snprintf(host, sizeof(host), "%.*s", (int)n, h);
+        if (h != r->hosts) fprintf(f, ", ");
+        write_json_string(f, host);
+        h += n;
+        if (*h == ',') h++;
+    }
+    fprintf(f, "]}\n");
+}
+
+/**
+ * write_csv
+ * ---------
+ * Writes one run as a CSV row, preceded by the header row if the file is
+ * empty. Every phase gets a min, mean, max and bytes column.
+ */
+static void write_csv(FILE *f, const char *timestamp, const run_result *r) {
+    if (ftell(f) == 0) {
+        fprintf(f, "timestamp,N,processes,threads,algorithm,kernel,precision,replication,input,warmup,repeat,"
+                   "seconds,seconds_mean,seconds_stddev,seconds_best,"
+                   "gflops,gflops_per_process,peak_per_core,percent_of_peak,verified,verify_residual,fp32_error");
+        for (int p = 0; p < NUM_PHASES; p++) {
+            const char *k = phase_key(p);
+            fprintf(f, ",%s_min,%s_mean,%s_max,%s_bytes", k, k, k, k);
+        }
+        fprintf(f, ",hosts\n");
+    }
+
+    fprintf(f, "%s,%d,%d,%d,", timestamp, r->N, r->processes, r->threads);
+    write_csv_string(f, r->algorithm);
+    fputc(',', f);
+    write_csv_string(f, r->kernel);
+    fputc(',', f);
+    write_csv_string(f, r->precision);
+    fprintf(f, ",%d,", r->replication);
+    write_csv_string(f, r->input);
+    fprintf(f, ",%d,%d,%.9g,%.9g,%.9g,%.9g", r->warmup, r->repeat, r->seconds->median,
+            r->seconds->mean, r->seconds->stddev, r->seconds->best);
+    fprintf(f, ",%.9g,%.9g", r->gflops, r->gflops / r->processes);
+    if (r->peak > 0.0) {
+        double total_peak = r->peak * r->processes * r->threads;
+        fprintf(f, ",%.9g,%.9g", r->peak, 100.0 * r->gflops / total_peak);
+    } else {
+        fprintf(f, ",,");
+    }
+    if (r->verify) {
+        fprintf(f, ",%d,%.9g,", r->verify->passed, r->verify->residual);
+        if (!isnan(r->verify->ref_error)) fprintf(f, "%.9g", r->verify->ref_error);
+    } else {
+        fprintf(f, ",,,");
+    }
+    for (int p = 0; p < NUM_PHASES; p++) {
+        fprintf(f, ",%.9g,%.9g,%.9g,%.17g", r->phases->min[p], r->phases->mean[p],
+                r->phases->max[p], r->phases->bytes[p]);
+    }
+    fputc(',', f);
+    write_csv_string(f, r->hosts);
+    fputc('\n', f);
+}
+
+/**
+ * append_results
+ * --------------
+ * Appends the record of one run to path, as CSV if the name ends in .csv
+ * and as a JSON line otherwise. Only called on rank 0.
+ *
+ * Returns:
+ *   0 on success, 1 if the file could not be opened.
+ */
+int append_results(const char *path, const run_result *r) {
+    FILE *f = fopen(path, "a");
+    if (!f) {
+        fprintf(stderr, "Failed to open %s for appending results\n", path);
+        return 1;
+    }
+    fseek(f, 0, SEEK_END);
+
+    // UTC time of the record in ISO 8601
+    char timestamp[32];
+    time_t now = time(NULL);
+    strftime(timestamp, sizeof(timestamp), "%Y-%m-%dT%H:%M:%SZ", gmtime(&now));
+
+    size_t len = strlen(path);
+    if (len >= 4 && strcmp(path + len - 4, ".csv") == 0) {
+        write_csv(f, timestamp, r);
+    } else {
+        write_json(f, timestamp, r);
+    }
+    fclose(f);
+    return 0;
+}
@@ -0,0 +1,40 @@
+/**
+ * Machine-Readable Results
+ * With --results FILE rank 0 appends one record per run to FILE, holding
+ * every parameter and metric of the run, so benchmark campaigns can be
+ * collected without scraping the text output. Files ending in .csv get a
+ * CSV row (and a header row when the file is new), anything else gets one
+ * JSON object per line (JSON Lines).
+ */
+
+#ifndef RESULTS_H
+#define RESULTS_H
+
+#include "timing.h"
+#include "verify.h"
+
+/**
+ * run_result
+ * ----------
+ * Everything recorded about one run.
+ */
+typedef struct {
+    int N;                        // size of the matrices (NxN)
+    int processes, threads;       // MPI processes and threads per process
+    const char *algorithm, *kernel;
+    const char *precision;        // element types, e.g. "mixed"
+    int replication;              // replication factor of the 2.5d algorithm
+    const char *input;            // where A and B came from, e.g. "philox (seed 42)"
+    int warmup, repeat;           // untimed and timed runs of the multiplication
+    const sample_stats *seconds;  // execution time over the timed runs
+    double gflops;                // 2N^3 / median seconds
+    double peak;                  // peak GFLOP/s of one core, 0 if unknown
+    const verify_result *verify;  // outcome of --verify, NULL if not checked
+    const phase_summary *phases;  // per-phase times over the processes
+    const char *hosts;            // comma separated names of the nodes used
+} run_result;
+
+char *gather_hosts(void);
+int append_results(const char *path, const run_result *r);
+
+#endif
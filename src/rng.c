@@ -0,0 +1,108 @@
+/**
+ * Counter-Based Random Matrix Generation
+ * See rng.h.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include "elem.h"
+#include "rng.h"
+
+#define PHILOX_M0 0xD2511F53u
+#define PHILOX_M1 0xCD9E8D57u
+#define PHILOX_W0 0x9E3779B9u   // golden ratio
+#define PHILOX_W1 0xBB67AE85u   // sqrt(3) - 1
+#define PHILOX_ROUNDS 10
+
+/**
+ * philox4x32
+ * ----------
+ * One Philox4x32-10 evaluation: out = bijection(ctr) under key.
+ *
+ * Notes:
+ *   Each round does two 32x32 -> 64 bit multiplies and mixes the halves
+ *   with the other two counter words and the key, the key is bumped by the
+ *   Weyl constants between rounds.
+ */
+void philox4x32(const uint32_t ctr[4], const uint32_t key[2], uint32_t out[4]) {
+    uint32_t c0 = ctr[0], c1 = ctr[1], c2 = ctr[2], c3 = ctr[3];
+    uint32_t k0 = key[0], k1 = key[1];
+
+    for (int r = 0; r < PHILOX_ROUNDS; r++) {
+        uint64_t p0 = (uint64_t)PHILOX_M0 * c0;
+        uint64_t p1 = (uint64_t)PHILOX_M1 * c2;
+        uint32_t n0 = (uint32_t)(p1 >> 32) ^ c1 ^ k0;
+        uint32_t n2 = (uint32_t)(p0 >> 32) ^ c3 ^ k1;
+        c0 = n0;
+        c1 = (uint32_t)p1;
+        c2 = n2;
+        c3 = (uint32_t)p0;
+        k0 += PHILOX_W0;
+        k1 += PHILOX_W1;
+    }
+
+    out[0] = c0; out[1] = c1; out[2] = c2; out[3] = c3;
+}
+
+/**
+ * fill_block
+ * ----------
+ * Common part of philox_fill and philox_fill_elems: the values are always
+ * computed in float, then stored in the element format (see elem.h).
+ */
+static void fill_block(uint64_t seed, int matrix, int r0, int c0, int rows, int cols,
+                       void *dst, int ld, int format) {
+    const uint32_t key[2] = { (uint32_t)seed, (uint32_t)(seed >> 32) };
+    const float scale = (MATRIX_MAX - MATRIX_MIN) / 16777216.0f;  // 2^24
+
+    #pragma omp parallel for schedule(static)
+    for (int i = 0; i < rows; i++) {
+        size_t row = (size_t)i * ld;
+        uint32_t words[4];
+        int group = -1;
+
+        for (int j = 0; j < cols; j++) {
+            int col = c0 + j;
+            if (col / 4 != group) {
+                group = col / 4;
+                const uint32_t ctr[4] = { (uint32_t)group, (uint32_t)(r0 + i), (uint32_t)matrix, 0 };
+                philox4x32(ctr, key, words);
+            }
+            // the top 24 bits give a float in [0, 1) without rounding up to 1
+            float v = MATRIX_MIN + (float)(words[col % 4] >> 8) * scale;
+            elem_store(dst, row + j, format, v);
+        }
+    }
+}
+
+/**
+ * philox_fill / philox_fill_elems
+ * -------------------------------
+ * Fills a block of a random matrix with values in [MATRIX_MIN, MATRIX_MAX),
+ * stored as float or in an element format from elem.h.
+ *
+ * Parameters:
+ *   seed         - the same seed gives the same matrices
+ *   matrix       - which matrix (0 for A, 1 for B), so A and B differ
+ *   r0, c0       - global row and column of the top left element of the block
+ *   rows, cols   - size of the block
+ *   dst, ld      - where the block goes and the distance between its rows
+ *   format       - ELEM_* format of dst (philox_fill_elems only)
+ *
+ * Notes:
+ *   - Element (i, j) is word j % 4 of philox4x32({ j / 4, i, matrix, 0 }),
+ *     so its value only depends on (seed, matrix, i, j).
+ *   - Every format stores the same float values, exactly in double and
+ *     rounded in bfloat16 and half, so every precision multiplies the same
+ *     matrices (up to that rounding).
+ *   - Rows are independent, with OpenMP they are split between threads.
+ */
+void philox_fill(uint64_t seed, int matrix, int r0, int c0, int rows, int cols,
+                 float *dst, int ld) {
+    fill_block(seed, matrix, r0, c0, rows, cols, dst, ld, ELEM_FLOAT32);
+}
+
+void philox_fill_elems(uint64_t seed, int matrix, int r0, int c0, int rows, int cols,
+                       void *dst, int ld, int format) {
+    fill_block(seed, matrix, r0, c0, rows, cols, dst, ld, format);
+}
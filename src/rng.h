@@ -0,0 +1,26 @@
+/**
+ * Counter-Based Random Matrix Generation
+ * Philox4x32-10 (Salmon et al., "Parallel Random Numbers: As Easy as
+ * 1, 2, 3", SC'11) turns a counter and a key into 4 random 32-bit words
+ * without any state carried from one call to the next. Using the position
+ * of an element as the counter means any process (or thread) can generate
+ * any part of a matrix on its own, and the values never depend on how the
+ * matrix is split up.
+ */
+
+#ifndef RNG_H
+#define RNG_H
+
+#include <stdint.h>
+
+// Range of the random values, shared by every generator: [MATRIX_MIN, MATRIX_MAX)
+#define MATRIX_MIN -100.0f
+#define MATRIX_MAX 101.0f
+
+void philox4x32(const uint32_t ctr[4], const uint32_t key[2], uint32_t out[4]);
+void philox_fill(uint64_t seed, int matrix, int r0, int c0, int rows, int cols,
+                 float *dst, int ld);
+void philox_fill_elems(uint64_t seed, int matrix, int r0, int c0, int rows, int cols,
+                       void *dst, int ld, int format);
+
+#endif
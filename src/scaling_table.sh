@@ -0,0 +1,64 @@
+#!/bin/sh
+# Prints a speedup/efficiency table from the --results CSV of a scaling sweep.
+#
+# Usage: sh scaling_table.sh strong|weak RESULTS.csv
+#
+# Every row of the CSV is one run. The first row (the smallest process
+# count of the sweep) is the baseline:
+#   strong - same N for every run, speedup = T(base) / T(P) and
+#            efficiency = speedup * P(base) / P
+#   weak   - N grows so the work per process stays the same, the scaled
+#            speedup = GFLOP/s(P) / GFLOP/s(base) and efficiency =
+#            (GFLOP/s per process)(P) / (GFLOP/s per process)(base)
+
+if [ $# -ne 2 ] || { [ "$1" != strong ] && [ "$1" != weak ]; }; then
+    echo "Usage: $0 strong|weak RESULTS.csv" >&2
+    exit 1
+fi
+if [ ! -s "$2" ]; then
+    echo "$2 has no results" >&2
+    exit 1
+fi
+
+awk -v mode="$1" -v file="$2" '
+# splits a CSV line into f[1..n], fields may be quoted and contain commas
+function parse(line, f,    n, i, c, field, quoted) {
+    n = 0; field = ""; quoted = 0
+    for (i = 1; i <= length(line); i++) {
+        c = substr(line, i, 1)
+        if (quoted) {
+            if (c == "\"" && substr(line, i + 1, 1) == "\"") { field = field c; i++ }
+            else if (c == "\"") quoted = 0
+            else field = field c
+        } else if (c == "\"") quoted = 1
+        else if (c == ",") { f[++n] = field; field = "" }
+        else field = field c
+    }
+    f[++n] = field
+    return n
+}
+
+NR == 1 {
+    n = parse($0, h)
+    for (i = 1; i <= n; i++) col[h[i]] = i
+    printf "%s scaling (%s)\n", (mode == "strong" ? "Strong" : "Weak"), file
+    printf "%6s %8s %12s %12s %10s %11s\n", "NP", "N", "Time (s)", "GFLOP/s", "Speedup", "Efficiency"
+    next
+}
+
+{
+    parse($0, f)
+    np = f[col["processes"]]; N = f[col["N"]]
+    t = f[col["seconds"]]; gf = f[col["gflops"]]
+    if (NR == 2) { np0 = np; t0 = t; gf0 = gf }
+
+    if (mode == "strong") {
+        speedup = t0 / t
+        eff = speedup * np0 / np
+    } else {
+        speedup = gf / gf0
+        eff = (gf / np) / (gf0 / np0)
+    }
+    printf "%6d %8d %12.6f %12.3f %10.2f %10.1f%%\n", np, N, t, gf, speedup, 100 * eff
+}
+' "$2"
@@ -0,0 +1,146 @@
+/**
+ * Per-Phase Timing
+ * See timing.h.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <mpi.h>
+#include "timing.h"
+
+// names shown in the report, and identifiers used in the results file
+static const char *phase_names[NUM_PHASES] = {
+    "generation", "scatter", "broadcast", "local compute", "gather", "file I/O", "verification", "formatting"
+};
+static const char *phase_keys[NUM_PHASES] = {
+    "generation", "scatter", "broadcast", "compute", "gather", "file_io", "verify", "formatting"
+};
+
+/**
+ * phase_lap
+ * ---------
+ * Adds the time since *since to a phase and restarts the clock.
+ *
+ * Parameters:
+ *   times - per-phase counters of this process
+ *   phase - PHASE_* the time is added to
+ *   since - start of the lap, set to the current time
+ *
+ * Notes:
+ *   Used like a stopwatch: set t = MPI_Wtime() once, then after every step
+ *   call phase_lap(times, PHASE_..., &t). Consecutive laps cover the time
+ *   between them without gaps, so the phases add up to the whole span.
+ */
+void phase_lap(double *times, int phase, double *since) {
+    double now = MPI_Wtime();
+    times[phase] += now - *since;
+    *since = now;
+}
+
+/**
+ * phase_name / phase_key
+ * ----------------------
+ * Name of a phase for people, and as an identifier (no spaces).
+ */
+const char *phase_name(int phase) {
+    return phase_names[phase];
+}
+
+const char *phase_key(int phase) {
+    return phase_keys[phase];
+}
+
+/**
+ * reduce_phases
+ * -------------
+ * Collective: reduces the phase counters of all processes onto rank 0.
+ *
+ * Parameters:
+ *   times - per-phase seconds of this process, NUM_PHASES entries
+ *   bytes - bytes this process received in each phase, NUM_PHASES entries
+ *   s     - filled in on rank 0 only
+ */
+void reduce_phases(const double *times, const double *bytes, phase_summary *s) {
+    double sum[NUM_PHASES];
+    int size;
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+    MPI_Reduce(times, s->min, NUM_PHASES, MPI_DOUBLE, MPI_MIN, 0, MPI_COMM_WORLD);
+    MPI_Reduce(times, s->max, NUM_PHASES, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+    MPI_Reduce(times, sum, NUM_PHASES, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
+    MPI_Reduce(bytes, s->bytes, NUM_PHASES, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
+    for (int p = 0; p < NUM_PHASES; p++) s->mean[p] = sum[p] / size;
+}
+
+/**
+ * print_phase_report
+ * ------------------
+ * Prints one line per phase with the min, mean and max over the processes.
+ *
+ * Parameters:
+ *   s - phase times from reduce_phases
+ *   f - where the table goes
+ *
+ * Notes:
+ *   - The imbalance column is max / mean. 1.00 means every process spent the
+ *     same time in the phase; a large value means some process took much
+ *     longer than the rest, and the others waited for it. Phases nobody spent
+ *     time in are left out.
+ *   - The bandwidth column is the bytes received by all processes divided
+ *     by the max time, i.e. the rate the phase as a whole moved data at.
+ */
+void print_phase_report(const phase_summary *s, FILE *f) {
+    fprintf(f, "%-15s %12s %12s %12s %10s %10s\n",
+            "Phase", "Min (s)", "Mean (s)", "Max (s)", "Imbalance", "GB/s");
+    for (int p = 0; p < NUM_PHASES; p++) {
+        if (s->max[p] <= 0.0) continue;
+        fprintf(f, "%-15s %12.6f %12.6f %12.6f %10.2f ",
+                phase_names[p], s->min[p], s->mean[p], s->max[p], s->max[p] / s->mean[p]);
+        if (s->bytes[p] > 0.0) {
+            fprintf(f, "%10.3f\n", s->bytes[p] / s->max[p] / 1e9);
+        } else {
+            fprintf(f, "%10s\n", "-");
+        }
+    }
+    fprintf(f, "\n");
+}
+
+static int compare_doubles(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * compute_sample_stats
+ * --------------------
+ * Median, mean, standard deviation and minimum of n > 0 samples.
+ *
+ * Notes:
+ *   The standard deviation is the sample one (divided by n - 1), 0 for a
+ *   single sample. The median is the better figure for comparing runs, one
+ *   slow repeat (a page fault storm, a noisy neighbour) barely moves it.
+ */
+void compute_sample_stats(const double *samples, int n, sample_stats *s) {
+    double *sorted = malloc(n * sizeof(double));
+    if (!sorted) {
+        fprintf(stderr, "Memory allocation failed\n");
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+    memcpy(sorted, samples, n * sizeof(double));
+    qsort(sorted, n, sizeof(double), compare_doubles);
+
+    s->median = (n % 2) ? sorted[n / 2] : 0.5 * (sorted[n / 2 - 1] + sorted[n / 2]);
+    s->best = sorted[0];
+
+    double sum = 0.0;
+    for (int i = 0; i < n; i++) sum += samples[i];
+    s->mean = sum / n;
+
+    double sq = 0.0;
+    for (int i = 0; i < n; i++) sq += (samples[i] - s->mean) * (samples[i] - s->mean);
+    s->stddev = (n > 1) ? sqrt(sq / (n - 1)) : 0.0;
+
+    free(sorted);
+}
@@ -0,0 +1,57 @@
+/**
+ * Per-Phase Timing
+ * Every process adds the time it spends in each phase of a run to its own
+ * counters. At the end the counters are reduced over all processes, and
+ * the min, mean and max per phase show whether a run is limited by
+ * communication or by computation, and whether some process is a straggler.
+ * The communication phases also count the bytes each process received,
+ * which gives their effective bandwidth. The ooc algorithm counts the
+ * bytes it reads and writes under file I/O.
+ */
+
+#ifndef TIMING_H
+#define TIMING_H
+
+#include <stdio.h>
+
+enum {
+    PHASE_GENERATE,     // generating A and B (rand() on rank 0, or philox)
+    PHASE_SCATTER,      // distributing A (and the blocks of B) from rank 0
+    PHASE_BROADCAST,    // exchanging B: broadcasts, allgathers, panel broadcasts, shifts
+    PHASE_COMPUTE,      // the local multiplication kernel
+    PHASE_GATHER,       // collecting C: gathers and the 2.5d reduction
+    PHASE_FILE_IO,      // reading --a/--b and writing --output
+    PHASE_VERIFY,       // checking C with --verify
+    PHASE_FORMAT,       // formatting and writing the text output on rank 0
+    NUM_PHASES
+};
+
+/**
+ * phase_summary
+ * -------------
+ * Phase times of all processes, as reduced onto rank 0 by reduce_phases.
+ */
+typedef struct {
+    double min[NUM_PHASES];      // seconds, fastest process
+    double mean[NUM_PHASES];     // seconds, mean over the processes
+    double max[NUM_PHASES];      // seconds, slowest process
+    double bytes[NUM_PHASES];    // bytes received by all processes together
+} phase_summary;
+
+/**
+ * sample_stats
+ * ------------
+ * Summary of the execution times of repeated runs.
+ */
+typedef struct {
+    double median, mean, stddev, best;
+} sample_stats;
+
+void phase_lap(double *times, int phase, double *since);
+const char *phase_name(int phase);
+const char *phase_key(int phase);
+void reduce_phases(const double *times, const double *bytes, phase_summary *s);
+void print_phase_report(const phase_summary *s, FILE *f);
+void compute_sample_stats(const double *samples, int n, sample_stats *s);
+
+#endif
@@ -0,0 +1,207 @@
+/**
+ * Result Verification
+ * See verify.h.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <mpi.h>
+#include "verify.h"
+#include "rng.h"
+
+// Index of the random vector for philox_fill, apart from A and B
+#define VERIFY_VECTOR 3
+
+// Largest residual accepted, 16 times the unit roundoff of the type C is
+// summed in: float (2^-24), or double (2^-53) in the double and mixed precisions
+#ifndef VERIFY_TOLERANCE
+#define VERIFY_TOLERANCE 0x1p-20
+#endif
+#ifndef VERIFY_TOLERANCE_DOUBLE
+#define VERIFY_TOLERANCE_DOUBLE 0x1p-49
+#endif
+
+/**
+ * row_dot
+ * -------
+ * Adds row * v to y and |row| * v_abs to y_abs (if not NULL), for a row
+ * of `cols` elements in `format` (see elem.h) and the matching entries of
+ * v and v_abs.
+ */
+static void row_dot(const void *row, int format, int cols, const double *v,
+                    const double *v_abs, double *y, double *y_abs) {
+    double sum = 0.0, sum_abs = 0.0;
+    for (int j = 0; j < cols; j++) {
+        double a = elem_load(row, j, format);
+        sum += a * v[j];
+        sum_abs += fabs(a) * v_abs[j];
+    }
+    *y += sum;
+    if (y_abs) *y_abs += sum_abs;
+}
+
+/**
+ * tile_matvec
+ * -----------
+ * Adds tile * v to y and |tile| * |v| to y_abs, both indexed by global row.
+ *
+ * Parameters:
+ *   t      - tile of the matrix
+ *   format - element format of the tile, in_format or out_format of run_ctx
+ *   v      - full vector the tile's columns are multiplied with
+ *   v_abs  - the vector whose entries multiply |tile| (|v| itself, or a
+ *            vector of sums of absolute values)
+ *   y      - receives the product, N entries
+ *   y_abs  - receives the product with the absolute values, N entries or NULL
+ */
+static void tile_matvec(const matrix_tile *t, int format, const double *v, const double *v_abs,
+                        double *y, double *y_abs) {
+    #pragma omp parallel for schedule(static)
+    for (int i = 0; i < t->rows; i++) {
+        row_dot(ELEM(t->data, (size_t)i * t->ld, t->size), format, t->cols, v + t->c0,
+                v_abs + t->c0, &y[t->r0 + i], y_abs ? &y_abs[t->r0 + i] : NULL);
+    }
+}
+
+/**
+ * tile_matvec_fp32
+ * ----------------
+ * tile_matvec on the float values Philox generated for the tile, before
+ * they were rounded to the element format of the run.
+ *
+ * Notes:
+ *   The rows are generated again one at a time, so this needs no copy of
+ *   the tile.
+ */
+static void tile_matvec_fp32(const run_ctx *ctx, int matrix, const matrix_tile *t,
+                             const double *v, const double *v_abs, double *y, double *y_abs) {
+    #pragma omp parallel
+    {
+        float *row = malloc((t->cols > 0 ? t->cols : 1) * sizeof(float));
+        if (!row) {
+            fprintf(stderr, "Memory allocation failed\n");
+            MPI_Abort(MPI_COMM_WORLD, 1);
+        }
+        #pragma omp for schedule(static)
+        for (int i = 0; i < t->rows; i++) {
+            philox_fill(ctx->seed, matrix, t->r0 + i, t->c0, 1, t->cols, row, t->cols);
+            row_dot(row, ELEM_FLOAT32, t->cols, v + t->c0, v_abs + t->c0,
+                    &y[t->r0 + i], &y_abs[t->r0 + i]);
+        }
+        free(row);
+    }
+}
+
+/**
+ * max_residual
+ * ------------
+ * max over i of |c_i - r_i| / scale_i, the residual of verify_result.
+ */
+static double max_residual(int N, const double *c, const double *r, const double *scale) {
+    double residual = 0.0;
+    for (int i = 0; i < N; i++) {
+        double diff = fabs(c[i] - r[i]);
+        // a zero scale means row i of A or B x is all 0's, any difference is an error
+        double res = scale[i] > 0.0 ? diff / scale[i] : (diff > 0.0 ? INFINITY : 0.0);
+        // a NaN in C fails the test as well
+        if (isnan(res)) return res;
+        if (res > residual) residual = res;
+    }
+    return residual;
+}
+
+/**
+ * verify_product
+ * --------------
+ * Collective: Freivalds' test of the C left by the last run.
+ *
+ * Parameters:
+ *   algo - the algorithm that ran, its tile hook locates A, B and C
+ *   ctx  - the run, after run and before cleanup
+ *   v    - filled in on every process
+ *
+ * Notes:
+ *   - x is generated with Philox from the seed, so it is the same on every
+ *     process without sending it, and a failure can be reproduced.
+ *   - The products are accumulated in double, so their own rounding is
+ *     negligible next to the float rounding in C. With C in double it is
+ *     of the same order, which the 16 u of VERIFY_TOLERANCE_DOUBLE leaves
+ *     room for.
+ *   - Each row's difference is scaled by (|A| (|B| |x|))_i. The worst
+ *     case rounding error of a float product is N * u times that scale
+ *     (u = 2^-24), but the errors are mostly random: each element of C is
+ *     off by about sqrt(N) * u (Higham and Mary, "A New Approach to
+ *     Probabilistic Rounding Error Analysis", 2019), and the random signs
+ *     of x cancel another factor sqrt(N) in the sum over a row. Correct
+ *     results stay around u for every N and kernel, so the tolerance is a
+ *     fixed 16 u of the type C is summed in. A wrong block of C gives residuals orders of magnitude
+ *     above it; a single wrong element of size |C_ij| gives about N^-1.5.
+ *   - With bfloat16 or half A and B the check is against the rounded A and
+ *     B the kernel multiplied. When they came from Philox the float values
+ *     before the rounding are generated again, and the same residual of C
+ *     against their product is the error of the run against an fp32
+ *     reference. It is dominated by the rounding of A and B to 8 (bfloat16)
+ *     or 11 (half) significant bits, so fp16 comes out about 8 times lower.
+ */
+void verify_product(const algorithm_info *algo, const run_ctx *ctx, verify_result *v) {
+    int N = ctx->N;
+    matrix_tile ta, tb, tc;
+    algo->tile(ctx, MATRIX_A, &ta);
+    algo->tile(ctx, MATRIX_B, &tb);
+    algo->tile(ctx, MATRIX_C, &tc);
+
+    // 16-bit A and B from Philox also get the fp32 reference
+    int half = (ctx->in_format == ELEM_BFLOAT16 || ctx->in_format == ELEM_FLOAT16);
+    int ref = half && ctx->distributed_input && ctx->input[MATRIX_A] == MPI_FILE_NULL;
+    int vecs = ref ? 5 : 3;
+
+    // x and |x|, then B x and |B| |x|, then A (B x), |A| (|B| |x|) and C x,
+    // and for the reference the same products with the fp32 A and B
+    float *xf = malloc(N * sizeof(float));
+    double *x = malloc(2 * (size_t)N * sizeof(double));
+    double *bx = calloc((ref ? 4 : 2) * (size_t)N, sizeof(double));
+    double *sums = calloc(vecs * (size_t)N, sizeof(double));
+    if (!xf || !x || !bx || !sums) {
+        fprintf(stderr, "Memory allocation failed\n");
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+    double *x_abs = x + N, *bx_abs = bx + N;
+    double *abx = sums, *abx_abs = sums + N, *cx = sums + 2 * (size_t)N;
+    double *bx_ref = bx + 2 * (size_t)N, *bx_ref_abs = bx + 3 * (size_t)N;
+    double *abx_ref = sums + 3 * (size_t)N, *abx_ref_abs = sums + 4 * (size_t)N;
+
+    philox_fill(ctx->seed, VERIFY_VECTOR, 0, 0, 1, N, xf, N);
+    for (int j = 0; j < N; j++) {
+        x[j] = xf[j];
+        x_abs[j] = fabs(x[j]);
+    }
+    free(xf);
+
+    // B x needs all of x, and A (B x) all of B x
+    tile_matvec(&tb, ctx->in_format, x, x_abs, bx, bx_abs);
+    if (ref) tile_matvec_fp32(ctx, MATRIX_B, &tb, x, x_abs, bx_ref, bx_ref_abs);
+    MPI_Allreduce(MPI_IN_PLACE, bx, (ref ? 4 : 2) * N, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+    tile_matvec(&ta, ctx->in_format, bx, bx_abs, abx, abx_abs);
+    if (ref) tile_matvec_fp32(ctx, MATRIX_A, &ta, bx_ref, bx_ref_abs, abx_ref, abx_ref_abs);
+    tile_matvec(&tc, ctx->out_format, x, x_abs, cx, NULL);
+
+    double residuals[2] = { 0.0, NAN };
+    if (ctx->rank == 0) {
+        MPI_Reduce(MPI_IN_PLACE, sums, vecs * N, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
+        residuals[0] = max_residual(N, cx, abx, abx_abs);
+        if (ref) residuals[1] = max_residual(N, cx, abx_ref, abx_ref_abs);
+    } else {
+        MPI_Reduce(sums, NULL, vecs * N, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
+    }
+    MPI_Bcast(residuals, 2, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+    v->residual = residuals[0];
+    v->ref_error = residuals[1];
+
+    v->tolerance = (ctx->out_format == ELEM_FLOAT64) ? VERIFY_TOLERANCE_DOUBLE : VERIFY_TOLERANCE;
+    v->passed = (v->residual <= v->tolerance);
+
+    free(x);
+    free(bx);
+    free(sums);
+}
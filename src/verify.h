@@ -0,0 +1,33 @@
+/**
+ * Result Verification
+ * Freivalds' test: for a random vector x, C = A * B implies
+ * C * x = A * (B * x). Both sides are matrix-vector products, so checking
+ * them costs O(N^2) instead of the O(N^3) of the multiplication, and a
+ * wrong C almost never passes for a random x.
+ *
+ * Every process only uses the tiles of A, B and C it already holds (see
+ * the tile hook in algorithms.h), nothing is gathered. The vectors are
+ * summed over the processes, which costs a few N-element reductions.
+ */
+
+#ifndef VERIFY_H
+#define VERIFY_H
+
+#include "algorithms.h"
+
+/**
+ * verify_result
+ * -------------
+ * Outcome of verify_product, the same on every process.
+ */
+typedef struct {
+    double residual;     // max over i of |C x - A (B x)|_i / (|A| (|B| |x|))_i
+    double tolerance;    // largest residual the rounding of C can explain
+    int passed;          // residual <= tolerance
+    double ref_error;    // the residual against the fp32 A and B before their rounding
+                         // to bfloat16 or half, NAN unless both came from Philox
+} verify_result;
+
+void verify_product(const algorithm_info *algo, const run_ctx *ctx, verify_result *v);
+
+#endif